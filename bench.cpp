@@ -0,0 +1,411 @@
+#include "lob.h"
+#include "lobster_parser.h"
+#include "lobster_replay.h"
+#include "order_gateway.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Micro- and macro-benchmarks of the order book and the LOBSTER pipeline.
+// Results are printed to stdout as JSON so runs can be diffed between versions:
+//
+//   ./lob_bench.exe [lobster_message_file.csv]
+//
+// Without a file, a synthetic LOBSTER file is generated for the parse/replay benchmarks.
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    constexpr Price MID_PRICE = 5850000; // $585.00 in ticks
+    constexpr Price TICK = 100;          // One cent
+    constexpr unsigned SEED = 42;
+
+    /** Latency distribution of one benchmark. */
+    struct BenchResult
+    {
+        std::string name;       // Benchmark name, "<levels>/<operation>" for book benchmarks
+        std::vector<double> ns; // Nanoseconds per operation, one entry per sample
+    };
+
+    double elapsed_ns(Clock::time_point start, Clock::time_point end)
+    {
+        return std::chrono::duration<double, std::nano>(end - start).count();
+    }
+
+    // Library code reports progress on std::cout; keep it out of the JSON
+    class SilenceStdout
+    {
+    private:
+        std::ostringstream sink;
+        std::streambuf *saved;
+
+    public:
+        SilenceStdout() : saved(std::cout.rdbuf(sink.rdbuf())) {}
+        ~SilenceStdout() { std::cout.rdbuf(saved); }
+    };
+
+    Price random_resting_price(std::mt19937_64 &rng, OrderSide side)
+    {
+        Price offset = static_cast<Price>(1 + rng() % 100) * TICK;
+        return side == OrderSide::BUY ? MID_PRICE - offset : MID_PRICE + offset;
+    }
+
+    template <typename Book>
+    BenchResult bench_add_limit_order(const std::string &levels, size_t n)
+    {
+        std::mt19937_64 rng(SEED);
+        Book book;
+        book.configure_order_index(IdIndexMode::HASHED, n);
+
+        BenchResult result{levels + "/add_limit_order", {}};
+        result.ns.reserve(n);
+        for (size_t i = 0; i < n; i++)
+        {
+            OrderSide side = rng() % 2 ? OrderSide::BUY : OrderSide::SELL;
+            Price price = random_resting_price(rng, side);
+
+            auto start = Clock::now();
+            book.add_limit_order(side, price, 100);
+            result.ns.push_back(elapsed_ns(start, Clock::now()));
+        }
+        return result;
+    }
+
+    template <typename Book>
+    BenchResult bench_cancel_order(const std::string &levels, size_t n)
+    {
+        std::mt19937_64 rng(SEED);
+        Book book;
+        book.configure_order_index(IdIndexMode::HASHED, n);
+
+        std::vector<int> ids;
+        ids.reserve(n);
+        for (size_t i = 0; i < n; i++)
+        {
+            OrderSide side = rng() % 2 ? OrderSide::BUY : OrderSide::SELL;
+            ids.push_back(book.add_limit_order(side, random_resting_price(rng, side), 100));
+        }
+        std::shuffle(ids.begin(), ids.end(), rng);
+
+        BenchResult result{levels + "/cancel_order", {}};
+        result.ns.reserve(n);
+        for (int id : ids)
+        {
+            auto start = Clock::now();
+            book.cancel_order(id);
+            result.ns.push_back(elapsed_ns(start, Clock::now()));
+        }
+        return result;
+    }
+
+    template <typename Book>
+    BenchResult bench_market_sweep(const std::string &levels, size_t level_count, size_t samples)
+    {
+        BenchResult result{levels + "/add_market_order_sweep_" + std::to_string(level_count), {}};
+        result.ns.reserve(samples);
+        for (size_t s = 0; s < samples; s++)
+        {
+            // One order per ask level; the market order consumes all of them
+            Book book;
+            for (size_t i = 0; i < level_count; i++)
+                book.add_limit_order(OrderSide::SELL, MID_PRICE + static_cast<Price>(i + 1) * TICK, 100);
+
+            auto start = Clock::now();
+            book.add_market_order(OrderSide::BUY, static_cast<int>(level_count) * 100);
+            result.ns.push_back(elapsed_ns(start, Clock::now()));
+        }
+        return result;
+    }
+
+    template <typename Book>
+    BenchResult bench_depth_snapshot(const std::string &levels, size_t depth, size_t samples)
+    {
+        std::mt19937_64 rng(SEED);
+        Book book;
+        for (size_t i = 0; i < 20000; i++)
+        {
+            OrderSide side = rng() % 2 ? OrderSide::BUY : OrderSide::SELL;
+            book.add_limit_order(side, random_resting_price(rng, side), 100);
+        }
+
+        std::vector<DepthLevel> snapshot(depth);
+        BenchResult result{levels + "/get_depth_" + std::to_string(depth), {}};
+        result.ns.reserve(samples);
+        for (size_t s = 0; s < samples; s++)
+        {
+            auto start = Clock::now();
+            book.get_depth(snapshot.data(), depth);
+            result.ns.push_back(elapsed_ns(start, Clock::now()));
+        }
+        return result;
+    }
+
+    BenchResult bench_deep_queue_remove(size_t depth, size_t samples)
+    {
+        std::mt19937_64 rng(SEED);
+        OrderPool pool;
+        OrderQueue queue;
+        std::vector<Order *> orders;
+        orders.reserve(depth);
+        for (size_t i = 0; i < depth; i++)
+        {
+            Order *order = pool.allocate(Order(static_cast<int>(i), OrderSide::BUY, OrderType::LIMIT,
+                                               MID_PRICE, 100, 0));
+            queue.add_order(order);
+            orders.push_back(order);
+        }
+
+        BenchResult result{"order_queue/remove_order_depth_" + std::to_string(depth), {}};
+        result.ns.reserve(samples);
+        for (size_t s = 0; s < samples; s++)
+        {
+            // Remove from anywhere in the queue, then requeue at the back to keep the depth
+            Order *order = orders[rng() % depth];
+
+            auto start = Clock::now();
+            queue.remove_order(order);
+            result.ns.push_back(elapsed_ns(start, Clock::now()));
+
+            queue.add_order(order);
+        }
+        return result;
+    }
+
+    // Random walk of adds and deletes around the mid, in LOBSTER message format
+    void write_synthetic_lobster(const std::string &filename, size_t messages)
+    {
+        std::mt19937_64 rng(SEED);
+        std::ofstream file(filename);
+        std::vector<LobsterMessage> live;
+        double timestamp = 34200.0;
+        char line[128];
+
+        for (size_t i = 0; i < messages; i++)
+        {
+            timestamp += 0.0001 * static_cast<double>(1 + rng() % 20);
+            if (!live.empty() && rng() % 10 < 4)
+            {
+                size_t pick = rng() % live.size();
+                const LobsterMessage &msg = live[pick];
+                std::snprintf(line, sizeof(line), "%.9f,3,%d,%d,%lld,%d\n", timestamp, msg.order_id,
+                              msg.size, static_cast<long long>(msg.price), msg.direction);
+                live[pick] = live.back();
+                live.pop_back();
+            }
+            else
+            {
+                OrderSide side = rng() % 2 ? OrderSide::BUY : OrderSide::SELL;
+                LobsterMessage msg(timestamp, LobsterMessageType::NEW_ORDER, static_cast<int>(i + 1),
+                                   100, random_resting_price(rng, side), side == OrderSide::BUY ? 1 : -1);
+                std::snprintf(line, sizeof(line), "%.9f,1,%d,%d,%lld,%d\n", timestamp, msg.order_id,
+                              msg.size, static_cast<long long>(msg.price), msg.direction);
+                live.push_back(msg);
+            }
+            file << line;
+        }
+    }
+
+    BenchResult bench_lobster_parse(const std::string &filename, size_t runs)
+    {
+        BenchResult result{"lobster/parse", {}};
+        for (size_t r = 0; r < runs; r++)
+        {
+            LobsterParser parser;
+            Clock::time_point start, end;
+            {
+                SilenceStdout quiet;
+                start = Clock::now();
+                parser.load_file(filename, false);
+                end = Clock::now();
+            }
+            double messages = static_cast<double>(std::max<size_t>(parser.get_total_messages(), 1));
+            result.ns.push_back(elapsed_ns(start, end) / messages);
+        }
+        return result;
+    }
+
+    BenchResult bench_lobster_replay(const std::string &filename, size_t runs, size_t batch_size)
+    {
+        BenchResult result{batch_size > 1 ? "lobster/replay_batched" : "lobster/replay", {}};
+        LobsterReplayEngine engine;
+        engine.set_batch_size(batch_size);
+        {
+            SilenceStdout quiet;
+            engine.load_data(filename);
+        }
+
+        for (size_t r = 0; r < runs; r++)
+        {
+            Clock::time_point start, end;
+            int messages;
+            {
+                SilenceStdout quiet;
+                engine.reset();
+                start = Clock::now();
+                messages = engine.replay_silent();
+                end = Clock::now();
+            }
+            result.ns.push_back(elapsed_ns(start, end) / std::max(messages, 1));
+        }
+        return result;
+    }
+
+    // Client threads stream adds, cancels of their own resting orders and the odd market
+    // order through one gateway; each sample is wall time per command across all clients
+    BenchResult bench_gateway(size_t clients, size_t commands_per_client, size_t runs)
+    {
+        BenchResult result{"gateway/" + std::to_string(clients) + (clients == 1 ? "_client" : "_clients"), {}};
+        for (size_t r = 0; r < runs; r++)
+        {
+            OrderGateway gateway;
+            for (size_t c = 0; c < clients; c++)
+                gateway.add_client();
+            gateway.start();
+
+            std::atomic<bool> go(false);
+            std::vector<std::thread> threads;
+            for (size_t c = 0; c < clients; c++)
+            {
+                threads.emplace_back([&gateway, &go, c, commands_per_client]()
+                {
+                    int client = static_cast<int>(c);
+                    std::mt19937_64 rng(SEED + c);
+                    std::vector<int> resting;
+                    size_t sent = 0, received = 0;
+                    while (!go.load(std::memory_order_acquire))
+                        cpu_relax();
+
+                    while (received < commands_per_client)
+                    {
+                        if (sent < commands_per_client)
+                        {
+                            OrderSide side = rng() % 2 ? OrderSide::BUY : OrderSide::SELL;
+                            unsigned pick = static_cast<unsigned>(rng() % 20);
+                            BookCommand command{BookCommandType::LIMIT, side, 0, 100, random_resting_price(rng, side)};
+                            size_t victim = 0;
+                            if (pick == 0)
+                                command.type = BookCommandType::MARKET;
+                            else if (pick < 10 && !resting.empty())
+                            {
+                                victim = rng() % resting.size();
+                                command.type = BookCommandType::CANCEL;
+                                command.order_id = resting[victim];
+                            }
+
+                            if (gateway.try_submit(client, sent, command) == SubmitResult::QUEUED)
+                            {
+                                sent++;
+                                if (command.type == BookCommandType::CANCEL)
+                                {
+                                    resting[victim] = resting.back();
+                                    resting.pop_back();
+                                }
+                            }
+                        }
+
+                        GatewayResponse response;
+                        while (gateway.try_receive(client, response))
+                        {
+                            received++;
+                            if (response.type == BookCommandType::LIMIT)
+                                resting.push_back(response.result);
+                        }
+                    }
+                });
+            }
+
+            auto start = Clock::now();
+            go.store(true, std::memory_order_release);
+            for (std::thread &thread : threads)
+                thread.join();
+            auto end = Clock::now();
+            gateway.stop();
+
+            result.ns.push_back(elapsed_ns(start, end) / static_cast<double>(clients * commands_per_client));
+        }
+        return result;
+    }
+
+    double percentile(const std::vector<double> &sorted, double p)
+    {
+        size_t index = static_cast<size_t>(p / 100.0 * static_cast<double>(sorted.size() - 1) + 0.5);
+        return sorted[std::min(index, sorted.size() - 1)];
+    }
+
+    void print_json(const std::vector<BenchResult> &results)
+    {
+        std::printf("{\n  \"benchmarks\": [\n");
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            std::vector<double> sorted = results[i].ns;
+            std::sort(sorted.begin(), sorted.end());
+
+            double total = 0;
+            for (double ns : sorted)
+                total += ns;
+            double mean = sorted.empty() ? 0 : total / static_cast<double>(sorted.size());
+
+            std::printf("    {\"name\": \"%s\", \"samples\": %zu, "
+                        "\"ns_per_op\": {\"mean\": %.1f, \"p50\": %.1f, \"p90\": %.1f, \"p99\": %.1f, "
+                        "\"p99.9\": %.1f, \"max\": %.1f}, \"ops_per_sec\": %.0f}%s\n",
+                        results[i].name.c_str(), sorted.size(), mean,
+                        percentile(sorted, 50), percentile(sorted, 90), percentile(sorted, 99),
+                        percentile(sorted, 99.9), sorted.back(), mean > 0 ? 1e9 / mean : 0,
+                        i + 1 < results.size() ? "," : "");
+        }
+        std::printf("  ]\n}\n");
+    }
+
+    template <typename Book>
+    void run_book_benchmarks(const std::string &levels, std::vector<BenchResult> &results)
+    {
+        results.push_back(bench_add_limit_order<Book>(levels, 200000));
+        results.push_back(bench_cancel_order<Book>(levels, 200000));
+        for (size_t level_count : {1, 10, 100, 1000})
+            results.push_back(bench_market_sweep<Book>(levels, level_count, level_count >= 1000 ? 200 : 2000));
+        results.push_back(bench_depth_snapshot<Book>(levels, 10, 200000));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<BenchResult> results;
+
+    run_book_benchmarks<MapLimitOrderBook>("map", results);
+    run_book_benchmarks<LadderLimitOrderBook>("ladder", results);
+
+    for (size_t depth : {100, 10000})
+        results.push_back(bench_deep_queue_remove(depth, 200000));
+
+    for (size_t clients : {1, 4})
+        results.push_back(bench_gateway(clients, 1000000 / clients, 5));
+
+    std::string filename;
+    bool generated = argc < 2;
+    if (generated)
+    {
+        filename = "lob_bench_messages.csv";
+        write_synthetic_lobster(filename, 500000);
+    }
+    else
+        filename = argv[1];
+
+    results.push_back(bench_lobster_parse(filename, 5));
+    results.push_back(bench_lobster_replay(filename, 5, 1));
+    results.push_back(bench_lobster_replay(filename, 5, LobsterReplayEngine::RECOMMENDED_BATCH_SIZE));
+
+    if (generated)
+        std::remove(filename.c_str());
+
+    print_json(results);
+    return 0;
+}
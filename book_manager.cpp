@@ -0,0 +1,190 @@
+#include "book_manager.h"
+#include <iostream>
+#include <iomanip>
+
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+namespace
+{
+    // Keeps a worker on one core so its books stay in that core's caches
+    void pin_to_core(std::thread &thread, unsigned core)
+    {
+#ifdef __linux__
+        unsigned cores = std::thread::hardware_concurrency();
+        if (cores == 0)
+            return;
+
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(core % cores, &set);
+        pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#else
+        (void)thread;
+        (void)core;
+#endif
+    }
+}
+
+BookManager::BookManager(unsigned shard_count) : running(false), wall_seconds(0)
+{
+    if (shard_count == 0)
+        shard_count = std::thread::hardware_concurrency();
+    if (shard_count == 0)
+        shard_count = 1;
+
+    for (unsigned i = 0; i < shard_count; i++)
+        shards.push_back(std::make_unique<Shard>());
+}
+
+BookManager::~BookManager()
+{
+    finish();
+}
+
+int BookManager::add_symbol(const std::string &symbol)
+{
+    auto it = symbol_ids.find(symbol);
+    if (it != symbol_ids.end())
+        return it->second;
+
+    int id = static_cast<int>(books.size());
+    books.push_back(std::make_unique<LobsterReplayEngine>());
+    symbol_ids[symbol] = id;
+
+    // Round-robin keeps the number of books per shard even
+    shards[id % shards.size()]->symbol_ids.push_back(id);
+    return id;
+}
+
+bool BookManager::load_symbol(const std::string &symbol, const std::string &filename)
+{
+    // Streaming keeps memory bounded however many files are open at once
+    int id = add_symbol(symbol);
+    return books[id]->load_data(filename, true);
+}
+
+int BookManager::find_symbol(const std::string &symbol) const
+{
+    auto it = symbol_ids.find(symbol);
+    return it == symbol_ids.end() ? -1 : it->second;
+}
+
+void BookManager::run_shard(Shard &shard)
+{
+    auto shard_start = std::chrono::steady_clock::now();
+
+    // Replay the files loaded for this shard's books, one book after another
+    for (int id : shard.symbol_ids)
+        shard.messages.fetch_add(books[id]->replay_silent(), std::memory_order_relaxed);
+
+    // Then apply routed messages until the router closes the inbox
+    RoutedMessage routed;
+    while (true)
+    {
+        bool popped = shard.inbox.try_pop(routed);
+        if (!popped && shard.inbox.is_closed())
+            popped = shard.inbox.try_pop(routed);
+
+        if (popped)
+        {
+            books[routed.symbol_id]->process(routed.msg);
+            shard.messages.fetch_add(1, std::memory_order_relaxed);
+        }
+        else if (shard.inbox.is_closed())
+            break;
+        else
+            std::this_thread::yield();
+    }
+
+    shard.busy_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - shard_start).count();
+}
+
+void BookManager::start()
+{
+    if (running)
+        return;
+
+    running = true;
+    start_time = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < shards.size(); i++)
+    {
+        Shard &shard = *shards[i];
+        shard.worker = std::thread(&BookManager::run_shard, this, std::ref(shard));
+        pin_to_core(shard.worker, static_cast<unsigned>(i));
+    }
+}
+
+void BookManager::submit(int symbol_id, const LobsterMessage &msg)
+{
+    SpscRing<RoutedMessage> &inbox = shards[symbol_id % shards.size()]->inbox;
+    RoutedMessage routed{symbol_id, msg};
+    while (!inbox.try_push(routed))
+        std::this_thread::yield();
+}
+
+void BookManager::finish()
+{
+    if (!running)
+        return;
+
+    for (auto &shard : shards)
+        shard->inbox.close();
+    for (auto &shard : shards)
+        shard->worker.join();
+
+    wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    running = false;
+}
+
+size_t BookManager::shard_count() const
+{
+    return shards.size();
+}
+
+void BookManager::print_statistics() const
+{
+    ReplayStatistics total{};
+    for (const auto &book : books)
+    {
+        ReplayStatistics stats = book->get_statistics();
+        total.processed_messages += stats.processed_messages;
+        total.successful_operations += stats.successful_operations;
+        total.failed_operations += stats.failed_operations;
+        total.trades_executed += stats.trades_executed;
+        total.matched_trades += stats.matched_trades;
+        total.active_orders += stats.active_orders;
+    }
+
+    std::cout << "\n=== BOOK MANAGER STATISTICS ===" << std::endl;
+    std::cout << "Symbols: " << books.size() << " across " << shards.size() << " shards" << std::endl;
+
+    for (size_t i = 0; i < shards.size(); i++)
+    {
+        const Shard &shard = *shards[i];
+        long long messages = shard.messages.load(std::memory_order_relaxed);
+        std::cout << "  Shard " << i << ": " << shard.symbol_ids.size() << " symbols, "
+                  << messages << " messages";
+        if (shard.busy_seconds > 0)
+        {
+            std::cout << " (" << std::fixed << std::setprecision(0)
+                      << messages / shard.busy_seconds << " msgs/s)";
+        }
+        std::cout << std::endl;
+    }
+
+    std::cout << "Messages Processed: " << total.processed_messages << std::endl;
+    std::cout << "Successful Operations: " << total.successful_operations << std::endl;
+    std::cout << "Failed Operations: " << total.failed_operations << std::endl;
+    std::cout << "Trades Executed: " << total.trades_executed << std::endl;
+    std::cout << "Matched Trades: " << total.matched_trades << std::endl;
+    std::cout << "Active Orders: " << total.active_orders << std::endl;
+    if (wall_seconds > 0)
+    {
+        std::cout << "Throughput: " << std::fixed << std::setprecision(0)
+                  << total.processed_messages / wall_seconds << " msgs/s ("
+                  << std::setprecision(3) << wall_seconds << "s wall)" << std::endl;
+    }
+    std::cout << "===============================" << std::endl;
+}
@@ -0,0 +1,133 @@
+#ifndef BOOK_MANAGER_H
+#define BOOK_MANAGER_H
+
+#include "lobster_replay.h"
+#include "spsc_ring.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class BookManager
+ * @brief Hosts one replay book per symbol, sharded across pinned worker threads.
+ *
+ * Every symbol is owned by exactly one shard and only that shard's worker ever touches
+ * its book, so the matching path takes no locks. Files loaded for a symbol are replayed
+ * by its worker as soon as the manager starts; after that, messages submitted from a
+ * single router thread are forwarded to the owning worker through the shard's SPSC ring.
+ *
+ * Symbols must be added before start(); the set of books is fixed while workers run.
+ */
+class BookManager
+{
+public:
+    /** Number of messages buffered between the router and each shard. */
+    static constexpr size_t SHARD_RING_CAPACITY = 1 << 14;
+
+private:
+    /** A message addressed to one symbol's book. */
+    struct RoutedMessage
+    {
+        int symbol_id;      // Book the message applies to
+        LobsterMessage msg; // The message
+    };
+
+    /** A worker thread and the books it owns. */
+    struct Shard
+    {
+        std::thread worker;                 // Thread that owns the shard's books
+        SpscRing<RoutedMessage> inbox;      // Messages routed to this shard
+        std::vector<int> symbol_ids;        // Books owned by this shard
+        std::atomic<long long> messages;    // Messages processed by the worker
+        double busy_seconds;                // Worker run time, valid after finish()
+
+        Shard() : inbox(SHARD_RING_CAPACITY), messages(0), busy_seconds(0) {}
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::vector<std::unique_ptr<LobsterReplayEngine>> books; // Indexed by symbol id
+    std::unordered_map<std::string, int> symbol_ids;         // Symbol -> id
+    bool running;
+    double wall_seconds; // Time from start() to the end of finish()
+    std::chrono::steady_clock::time_point start_time;
+
+    /**
+     * @brief Worker loop: replays loaded files, then serves the inbox until it is closed.
+     * @param shard The shard this thread owns.
+     */
+    void run_shard(Shard &shard);
+
+public:
+    /**
+     * @brief Constructs a manager with a fixed number of shards.
+     * @param shard_count Number of worker threads; 0 uses one per core.
+     */
+    explicit BookManager(unsigned shard_count = 0);
+
+    /**
+     * @brief Stops the workers if they are still running.
+     */
+    ~BookManager();
+
+    BookManager(const BookManager &) = delete;
+    BookManager &operator=(const BookManager &) = delete;
+
+    /**
+     * @brief Adds a book for a symbol, or finds the existing one. Only before start().
+     * @param symbol The symbol.
+     * @return The symbol's id, used to route messages.
+     */
+    int add_symbol(const std::string &symbol);
+
+    /**
+     * @brief Adds a symbol and opens a LOBSTER file for its worker to replay. Only before start().
+     * @param symbol The symbol.
+     * @param filename Path to the symbol's LOBSTER message file.
+     * @return True if the file was opened, false otherwise.
+     */
+    bool load_symbol(const std::string &symbol, const std::string &filename);
+
+    /**
+     * @brief Looks up a symbol.
+     * @param symbol The symbol.
+     * @return The symbol's id, or -1 if it has no book.
+     */
+    int find_symbol(const std::string &symbol) const;
+
+    /**
+     * @brief Starts one pinned worker per shard.
+     */
+    void start();
+
+    /**
+     * @brief Routes a message to the shard that owns the symbol's book.
+     *
+     * Must be called from a single router thread between start() and finish().
+     * Blocks while the shard's ring is full.
+     * @param symbol_id The id returned by add_symbol.
+     * @param msg The message to apply.
+     */
+    void submit(int symbol_id, const LobsterMessage &msg);
+
+    /**
+     * @brief Waits for every worker to finish its files and routed messages, then stops them.
+     */
+    void finish();
+
+    /**
+     * @brief Gets the number of shards.
+     * @return The number of worker threads.
+     */
+    size_t shard_count() const;
+
+    /**
+     * @brief Prints per-shard throughput and replay statistics aggregated over all books.
+     */
+    void print_statistics() const;
+};
+
+#endif // BOOK_MANAGER_H
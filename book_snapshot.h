@@ -0,0 +1,70 @@
+#ifndef BOOK_SNAPSHOT_H
+#define BOOK_SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+
+/**
+ * @struct BookSnapshotHeader
+ * @brief Header of a saved order book, followed by order_count BookSnapshotRecords.
+ */
+struct BookSnapshotHeader
+{
+    char magic[8];         // BOOK_SNAPSHOT_MAGIC
+    uint32_t version;      // BOOK_SNAPSHOT_VERSION
+    uint32_t record_size;  // sizeof(BookSnapshotRecord)
+    int64_t next_order_id; // Id the book will assign to its next order
+    uint64_t order_count;  // Number of records that follow
+};
+
+/**
+ * @struct BookSnapshotRecord
+ * @brief One resting order of a saved book.
+ *
+ * Records are written bids then asks, best level first and in queue order within a
+ * level, so appending them in file order rebuilds every level with its time priority.
+ */
+struct BookSnapshotRecord
+{
+    int64_t price;       // Limit price in ticks
+    int64_t timestamp;   // Time the order was created
+    int32_t id;          // Order id
+    int32_t quantity;    // Remaining quantity
+    int8_t side;         // 1 = bid, -1 = ask
+    uint8_t reserved[7]; // Zero
+};
+
+static_assert(sizeof(BookSnapshotRecord) == 32, "BookSnapshotRecord must keep its on-disk layout");
+
+/** Identifies a saved order book. */
+constexpr char BOOK_SNAPSHOT_MAGIC[8] = {'L', 'O', 'B', 'B', 'O', 'O', 'K', '1'};
+
+/** Current book snapshot format version. */
+constexpr uint32_t BOOK_SNAPSHOT_VERSION = 1;
+
+/** Records buffered per read or write while saving and loading a book. */
+constexpr size_t BOOK_SNAPSHOT_BATCH = 4096;
+
+/**
+ * @brief Gets how many bytes are left in a stream, so counts read from a snapshot can
+ *        be checked before anything is sized from them.
+ * @param in The stream, positioned where reading continues.
+ * @return The bytes left, or UINT64_MAX if the stream cannot seek to tell.
+ */
+inline uint64_t snapshot_bytes_left(std::istream &in)
+{
+    std::streampos here = in.tellg();
+    if (here == std::streampos(-1))
+        return UINT64_MAX;
+
+    in.seekg(0, std::ios::end);
+    std::streampos end = in.tellg();
+    in.clear();
+    in.seekg(here);
+    if (end == std::streampos(-1) || end < here)
+        return UINT64_MAX;
+    return static_cast<uint64_t>(end - here);
+}
+
+#endif // BOOK_SNAPSHOT_H
@@ -0,0 +1,114 @@
+#include "latency_stats.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+
+double cycles_to_ns(uint64_t cycles)
+{
+    // Measure the counter against steady_clock once, over a few milliseconds
+    static const double ns_per_cycle = []
+    {
+        auto clock_start = std::chrono::steady_clock::now();
+        uint64_t cycle_start = read_cycles();
+        while (std::chrono::steady_clock::now() - clock_start < std::chrono::milliseconds(5))
+        {
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - clock_start).count();
+        uint64_t elapsed = read_cycles() - cycle_start;
+        return elapsed > 0 ? ns / static_cast<double>(elapsed) : 1.0;
+    }();
+
+    return static_cast<double>(cycles) * ns_per_cycle;
+}
+
+LatencyHistogram::LatencyHistogram() : counts{}, total(0), largest(0) {}
+
+uint64_t LatencyHistogram::bucket_upper_bound(size_t bucket)
+{
+    if (bucket < SUB_BUCKETS)
+        return bucket;
+
+    size_t shift = (bucket - SUB_BUCKETS) / SUB_BUCKETS;
+    uint64_t sub = (bucket - SUB_BUCKETS) % SUB_BUCKETS;
+    return ((SUB_BUCKETS + sub + 1) << shift) - 1;
+}
+
+uint64_t LatencyHistogram::value_at_percentile(double percentile) const
+{
+    if (total == 0)
+        return 0;
+
+    uint64_t rank = static_cast<uint64_t>(std::ceil(percentile / 100.0 * static_cast<double>(total)));
+    if (rank == 0)
+        rank = 1;
+
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < BUCKET_COUNT; bucket++)
+    {
+        seen += counts[bucket];
+        if (seen >= rank)
+            return std::min(bucket_upper_bound(bucket), largest);
+    }
+    return largest;
+}
+
+uint64_t LatencyHistogram::count() const
+{
+    return total;
+}
+
+uint64_t LatencyHistogram::max() const
+{
+    return largest;
+}
+
+void LatencyHistogram::clear()
+{
+    counts.fill(0);
+    total = 0;
+    largest = 0;
+}
+
+#ifdef LOB_LATENCY_STATS
+
+LatencyTable::LatencyTable(std::initializer_list<const char *> names)
+    : names(names.begin(), names.end()), histograms(names.size()) {}
+
+void LatencyTable::print(const std::string &title) const
+{
+    bool any = false;
+    for (const LatencyHistogram &histogram : histograms)
+        any = any || histogram.count() > 0;
+    if (!any)
+        return;
+
+    std::cout << "\n=== " << title << " (ns) ===" << std::endl;
+    std::cout << std::left << std::setw(20) << "Operation" << std::right
+              << std::setw(12) << "Count" << std::setw(10) << "p50" << std::setw(10) << "p99"
+              << std::setw(10) << "p99.9" << std::setw(12) << "max" << std::endl;
+
+    std::cout << std::fixed << std::setprecision(0);
+    for (size_t i = 0; i < histograms.size(); i++)
+    {
+        const LatencyHistogram &histogram = histograms[i];
+        if (names[i].empty() || histogram.count() == 0)
+            continue;
+
+        std::cout << std::left << std::setw(20) << names[i] << std::right
+                  << std::setw(12) << histogram.count()
+                  << std::setw(10) << cycles_to_ns(histogram.value_at_percentile(50))
+                  << std::setw(10) << cycles_to_ns(histogram.value_at_percentile(99))
+                  << std::setw(10) << cycles_to_ns(histogram.value_at_percentile(99.9))
+                  << std::setw(12) << cycles_to_ns(histogram.max()) << std::endl;
+    }
+}
+
+void LatencyTable::clear()
+{
+    for (LatencyHistogram &histogram : histograms)
+        histogram.clear();
+}
+
+#endif // LOB_LATENCY_STATS
@@ -0,0 +1,210 @@
+#ifndef LATENCY_STATS_H
+#define LATENCY_STATS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+/**
+ * @brief Reads a cheap, monotonic cycle counter (the TSC on x86, nanoseconds elsewhere).
+ * @return The current counter value.
+ */
+inline uint64_t read_cycles()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch())
+                                     .count());
+#endif
+}
+
+/**
+ * @brief Converts a read_cycles() interval to nanoseconds.
+ *
+ * The counter frequency is calibrated against steady_clock on first use.
+ * @param cycles Number of counter ticks.
+ * @return The interval in nanoseconds.
+ */
+double cycles_to_ns(uint64_t cycles);
+
+/**
+ * @class LatencyHistogram
+ * @brief Log-bucketed latency histogram in the style of HdrHistogram.
+ *
+ * Each power of two is split into SUB_BUCKETS linear buckets, so any recorded value is
+ * known to within 1/SUB_BUCKETS (about 6%) with a fixed 8 KB of counters and an O(1),
+ * allocation-free record. The exact maximum is kept separately.
+ */
+class LatencyHistogram
+{
+public:
+    /** Linear buckets per power of two. */
+    static constexpr size_t SUB_BUCKETS = 16;
+
+private:
+    static constexpr size_t SUB_BUCKET_BITS = 4;
+    static constexpr size_t BUCKET_COUNT = SUB_BUCKETS + (64 - SUB_BUCKET_BITS) * SUB_BUCKETS;
+
+    std::array<uint64_t, BUCKET_COUNT> counts;
+    uint64_t total;   // Number of recorded values
+    uint64_t largest; // Exact maximum value
+
+    static size_t bucket_of(uint64_t value)
+    {
+        if (value < SUB_BUCKETS)
+            return static_cast<size_t>(value);
+
+        size_t msb = 63 - static_cast<size_t>(__builtin_clzll(value));
+        size_t shift = msb - SUB_BUCKET_BITS;
+        return SUB_BUCKETS + shift * SUB_BUCKETS + static_cast<size_t>((value >> shift) & (SUB_BUCKETS - 1));
+    }
+
+    /**
+     * @brief Gets the largest value that falls into a bucket.
+     * @param bucket The bucket index.
+     * @return The bucket's upper bound.
+     */
+    static uint64_t bucket_upper_bound(size_t bucket);
+
+public:
+    /**
+     * @brief Constructs an empty histogram.
+     */
+    LatencyHistogram();
+
+    /**
+     * @brief Records one value.
+     * @param value The value, usually in read_cycles() ticks.
+     */
+    void record(uint64_t value)
+    {
+        counts[bucket_of(value)]++;
+        total++;
+        if (value > largest)
+            largest = value;
+    }
+
+    /**
+     * @brief Gets the value below which a percentage of recorded values fall.
+     * @param percentile The percentile (0-100).
+     * @return The value, accurate to the bucket width; 0 if nothing was recorded.
+     */
+    uint64_t value_at_percentile(double percentile) const;
+
+    /**
+     * @brief Gets the number of recorded values.
+     * @return The count.
+     */
+    uint64_t count() const;
+
+    /**
+     * @brief Gets the largest recorded value.
+     * @return The maximum.
+     */
+    uint64_t max() const;
+
+    /**
+     * @brief Removes every recorded value.
+     */
+    void clear();
+};
+
+#ifdef LOB_LATENCY_STATS
+
+/** True when latency instrumentation is compiled in (make LATENCY=on). */
+constexpr bool LATENCY_STATS_ENABLED = true;
+
+/**
+ * @class LatencyTable
+ * @brief A fixed set of named latency histograms, one per operation or message type.
+ */
+class LatencyTable
+{
+private:
+    std::vector<std::string> names;
+    std::vector<LatencyHistogram> histograms;
+
+public:
+    /**
+     * @brief Constructs one empty histogram per name.
+     * @param names Row names; rows with an empty name are never printed.
+     */
+    LatencyTable(std::initializer_list<const char *> names);
+
+    /**
+     * @brief Gets a row's histogram.
+     * @param index The row index.
+     * @return The histogram.
+     */
+    LatencyHistogram &operator[](size_t index)
+    {
+        return histograms[index];
+    }
+
+    /**
+     * @brief Prints p50, p99, p99.9 and max in nanoseconds for every non-empty row.
+     * @param title Heading of the table.
+     */
+    void print(const std::string &title) const;
+
+    /**
+     * @brief Clears every histogram.
+     */
+    void clear();
+};
+
+/**
+ * @class ScopedLatency
+ * @brief Records the cycles between its construction and destruction into a histogram.
+ */
+class ScopedLatency
+{
+private:
+    LatencyHistogram &histogram;
+    uint64_t start;
+
+public:
+    explicit ScopedLatency(LatencyHistogram &histogram) : histogram(histogram), start(read_cycles()) {}
+    ~ScopedLatency() { histogram.record(read_cycles() - start); }
+
+    ScopedLatency(const ScopedLatency &) = delete;
+    ScopedLatency &operator=(const ScopedLatency &) = delete;
+};
+
+/** Times the rest of the enclosing scope into row `index` of a LatencyTable. */
+#define LOB_MEASURE_LATENCY(table, index) \
+    ScopedLatency lob_scoped_latency_((table)[static_cast<size_t>(index)])
+
+#else
+
+/** True when latency instrumentation is compiled in (make LATENCY=on). */
+constexpr bool LATENCY_STATS_ENABLED = false;
+
+/**
+ * @class LatencyTable
+ * @brief Stand-in used when latency instrumentation is compiled out; it holds nothing.
+ */
+class LatencyTable
+{
+public:
+    LatencyTable(std::initializer_list<const char *>) {}
+    void print(const std::string &) const {}
+    void clear() {}
+};
+
+#define LOB_MEASURE_LATENCY(table, index) ((void)0)
+
+#endif // LOB_LATENCY_STATS
+
+#endif // LATENCY_STATS_H
@@ -1,239 +1,436 @@
 #include "lob.h"
+#include "book_snapshot.h"
+#include "market_data_feed.h"
+#include <algorithm>
 #include <chrono>
+#include <climits>
+#include <cstring>
 #include <iostream>
 #include <iomanip>
+#include <vector>
 
 // Order constructor implementation
-Order::Order(int id, OrderSide side, OrderType type, double price, int quantity, long long timestamp)
-    : id(id), side(side), type(type), price(price), quantity(quantity), timestamp(timestamp) {}
+Order::Order(int id, OrderSide side, OrderType type, Price price, int quantity, long long timestamp)
+    : id(id), side(side), type(type), price(price), quantity(quantity), timestamp(timestamp),
+      prev(nullptr), next(nullptr) {}
 
-LimitOrderBook::LimitOrderBook() : next_order_id(1) {}
+Order::Order() : Order(0, OrderSide::BUY, OrderType::LIMIT, 0, 0, 0) {}
 
-long long LimitOrderBook::get_timestamp()
+template <typename Levels, typename EventSink>
+BasicLimitOrderBook<Levels, EventSink>::BasicLimitOrderBook()
+    : bid_levels(OrderSide::BUY), ask_levels(OrderSide::SELL), next_order_id(1),
+      latency({"add_limit_order", "add_market_order", "cancel_order", "reduce_order",
+               "insert_order", "fill_order"}) {}
+
+template <typename Levels, typename EventSink>
+long long BasicLimitOrderBook<Levels, EventSink>::get_timestamp()
 {
     return std::chrono::duration_cast<std::chrono::microseconds>(
                std::chrono::steady_clock::now().time_since_epoch())
         .count();
 }
 
-void LimitOrderBook::execute_trade(std::shared_ptr<Order> aggressive_order,
-                                   std::shared_ptr<Order> passive_order,
-                                   int trade_quantity)
+template <typename Levels, typename EventSink>
+void BasicLimitOrderBook<Levels, EventSink>::emit_level(OrderSide side, Price price,
+                                                        const OrderQueue &queue)
+{
+    events.on_level_changed(LevelEvent{side, price, queue.get_total_quantity(), queue.size()});
+}
+
+template <typename Levels, typename EventSink>
+void BasicLimitOrderBook<Levels, EventSink>::execute_trade(const Order &aggressive_order,
+                                                           const Order &passive_order,
+                                                           int trade_quantity)
 {
-    std::cout << "TRADE: " << trade_quantity << " shares at $"
-              << std::fixed << std::setprecision(2) << passive_order->price << std::endl;
+    events.on_trade(TradeEvent{aggressive_order.id, passive_order.id, aggressive_order.side,
+                               passive_order.price, trade_quantity, aggressive_order.timestamp});
 }
 
-bool LimitOrderBook::process_price_level(std::shared_ptr<Order> order, OrderQueue &queue,
-                                         double level_price, bool is_market_order)
+template <typename Levels, typename EventSink>
+bool BasicLimitOrderBook<Levels, EventSink>::process_price_level(Order &order, OrderQueue &queue,
+                                                                 Price level_price, bool is_market_order)
 {
     // Check price compatibility for limit orders
     if (!is_market_order)
     {
-        if (order->side == OrderSide::BUY && order->price < level_price)
+        if (order.side == OrderSide::BUY && order.price < level_price)
             return false; // Buy limit can't match above limit price
 
-        if (order->side == OrderSide::SELL && order->price > level_price)
+        if (order.side == OrderSide::SELL && order.price > level_price)
             return false; // Sell limit can't match below limit price
     }
 
     // Process all orders at this price level while there's quantity remaining
-    while (order->quantity > 0 && !queue.empty())
+    OrderSide level_side = order.side == OrderSide::BUY ? OrderSide::SELL : OrderSide::BUY;
+    bool traded = false;
+    while (order.quantity > 0 && !queue.empty())
     {
-        auto passive_order = queue.front();
-        int trade_quantity = std::min(order->quantity, passive_order->quantity);
+        Order *passive_order = queue.front();
+        int trade_quantity = std::min(order.quantity, passive_order->quantity);
 
-        execute_trade(order, passive_order, trade_quantity);
+        execute_trade(order, *passive_order, trade_quantity);
+        traded = true;
 
-        // Update quantities
-        order->quantity -= trade_quantity;
-        passive_order->quantity -= trade_quantity;
+        // Update quantities; the queue adjusts the passive order so its level total stays exact
+        order.quantity -= trade_quantity;
+        int passive_remaining = passive_order->quantity - trade_quantity;
 
         // Handle passive order after trade
-        if (passive_order->quantity == 0)
+        if (passive_remaining == 0)
         {
-            order_locations.erase(passive_order->id);
+            // Filled orders leave the book and their slot goes back to the pool
             queue.pop();
+            order_locations.erase(passive_order->id);
+            order_pool.release(passive_order);
         }
         else
-            queue.update_quantity(passive_order->quantity);
+            queue.update_quantity(passive_remaining);
     }
 
+    // One level update per sweep of this level, however many orders it filled
+    if (traded)
+        emit_level(level_side, level_price, queue);
+
     return true; // Continue processing other price levels
 }
 
-void LimitOrderBook::match_market_order(std::shared_ptr<Order> market_order)
+template <typename Levels, typename EventSink>
+void BasicLimitOrderBook<Levels, EventSink>::match_against(Order &order, Levels &levels,
+                                                           bool is_market_order)
 {
-    if (market_order->side == OrderSide::BUY)
+    // Walk the opposite side best level first until filled or out of price
+    while (order.quantity > 0 && !levels.empty())
     {
-        // Market buy - match against asks (ascending price order)
-        auto it = ask_levels.begin();
-        while (market_order->quantity > 0 && it != ask_levels.end())
-        {
-            auto &[price, queue] = *it;
-
-            if (queue.empty())
-            {
-                it = ask_levels.erase(it);
-                continue;
-            }
+        Price price = levels.best_price();
+        OrderQueue &queue = levels.best_level();
 
-            process_price_level(market_order, queue, price, true);
+        if (!process_price_level(order, queue, price, is_market_order))
+            break; // No more favorable prices
 
-            if (queue.empty())
-                it = ask_levels.erase(it);
-            else
-                ++it;
-        }
+        if (queue.empty())
+            levels.erase(price);
     }
+}
+
+template <typename Levels, typename EventSink>
+void BasicLimitOrderBook<Levels, EventSink>::match_market_order(Order &market_order)
+{
+    // Market buy matches asks, market sell matches bids
+    if (market_order.side == OrderSide::BUY)
+        match_against(market_order, ask_levels, true);
     else
+        match_against(market_order, bid_levels, true);
+
+    // An unfilled market remainder never rests; report it as cancelled
+    if (market_order.quantity > 0)
     {
-        // Market sell - match against bids (descending price order)
-        auto it = bid_levels.begin();
-        while (market_order->quantity > 0 && it != bid_levels.end())
-        {
-            auto &[price, queue] = *it;
+        events.on_order_cancelled(OrderEvent{market_order.id, market_order.side, OrderType::MARKET,
+                                             0, market_order.quantity});
+    }
+}
 
-            if (queue.empty())
-            {
-                it = bid_levels.erase(it);
-                continue;
-            }
+template <typename Levels, typename EventSink>
+void BasicLimitOrderBook<Levels, EventSink>::match_limit_order(Order &limit_order)
+{
+    // Buy limits match asks at or below the limit, sell limits bids at or above it
+    Levels &opposite = limit_order.side == OrderSide::BUY ? ask_levels : bid_levels;
 
-            process_price_level(market_order, queue, price, true);
+    match_against(limit_order, opposite, false);
 
-            if (queue.empty())
-                it = bid_levels.erase(it);
-            else
-                ++it;
-        }
+    // Only the remainder that rests in the book takes a pool slot
+    if (limit_order.quantity > 0)
+        rest_order(limit_order);
+}
+
+template <typename Levels, typename EventSink>
+void BasicLimitOrderBook<Levels, EventSink>::rest_order(const Order &order)
+{
+    Levels &own = order.side == OrderSide::BUY ? bid_levels : ask_levels;
+
+    Order *resting = order_pool.allocate(order);
+    OrderQueue &queue = own.get_or_create(resting->price);
+    queue.add_order(resting);
+    order_locations.insert(resting->id, resting);
+
+    events.on_order_rested(OrderEvent{resting->id, resting->side, OrderType::LIMIT,
+                                      resting->price, resting->quantity});
+    emit_level(resting->side, resting->price, queue);
+}
+
+template <typename Levels, typename EventSink>
+int BasicLimitOrderBook<Levels, EventSink>::apply_limit(OrderSide side, Price price, int quantity,
+                                                        long long timestamp)
+{
+    Order order(next_order_id++, side, OrderType::LIMIT, price, quantity, timestamp);
+    events.on_order_accepted(OrderEvent{order.id, side, OrderType::LIMIT, price, quantity});
+    match_limit_order(order);
+    return order.id;
+}
+
+template <typename Levels, typename EventSink>
+void BasicLimitOrderBook<Levels, EventSink>::apply_market(OrderSide side, int quantity, long long timestamp)
+{
+    // Market orders never rest, so they live on the stack for the duration of the sweep
+    Order order(next_order_id++, side, OrderType::MARKET, 0, quantity, timestamp);
+    events.on_order_accepted(OrderEvent{order.id, side, OrderType::MARKET, 0, quantity});
+    match_market_order(order);
+}
+
+template <typename Levels, typename EventSink>
+bool BasicLimitOrderBook<Levels, EventSink>::apply_cancel(int order_id)
+{
+    Order **location = order_locations.find(order_id);
+    if (!location)
+        return false;
+
+    Order *order = *location;
+    Levels &levels = order->side == OrderSide::BUY ? bid_levels : ask_levels;
+
+    // The handle unlinks the order directly; the level is only needed to drop it when empty
+    bool found = false;
+    OrderQueue *queue = levels.find(order->price);
+    if (queue)
+    {
+        found = queue->remove_order(order);
+        emit_level(order->side, order->price, *queue);
+        if (queue->empty())
+            levels.erase(order->price);
     }
 
-    // Handle unfilled market order
-    if (market_order->quantity > 0)
+    if (found)
     {
-        std::cout << "WARNING: Market order partially filled. "
-                  << market_order->quantity << " shares remain unfilled." << std::endl;
+        events.on_order_cancelled(OrderEvent{order->id, order->side, OrderType::LIMIT,
+                                             order->price, order->quantity});
+        order_locations.erase(order_id);
+        order_pool.release(order);
     }
+
+    return found;
 }
 
-void LimitOrderBook::match_limit_order(std::shared_ptr<Order> limit_order)
+template <typename Levels, typename EventSink>
+int BasicLimitOrderBook<Levels, EventSink>::apply_reduce(int order_id, int quantity)
 {
-    if (limit_order->side == OrderSide::BUY)
-    {
-        // Buy limit order - match against asks at or below limit price
-        auto it = ask_levels.begin();
-        while (limit_order->quantity > 0 && it != ask_levels.end())
-        {
-            auto &[price, queue] = *it;
+    if (quantity <= 0)
+        return -1;
+
+    Order **location = order_locations.find(order_id);
+    if (!location)
+        return -1;
+
+    Order *order = *location;
+    if (quantity >= order->quantity)
+        return apply_cancel(order_id) ? 0 : -1;
+
+    Levels &levels = order->side == OrderSide::BUY ? bid_levels : ask_levels;
+    OrderQueue *queue = levels.find(order->price);
+    if (!queue)
+        return -1;
+
+    // Priority is by arrival, so shrinking an order leaves it where it is
+    if (!queue->reduce_order(order, quantity))
+        return -1;
+    events.on_order_cancelled(OrderEvent{order->id, order->side, OrderType::LIMIT, order->price, quantity});
+    emit_level(order->side, order->price, *queue);
+    return order->quantity;
+}
 
-            if (queue.empty())
-            {
-                it = ask_levels.erase(it);
-                continue;
-            }
+template <typename Levels, typename EventSink>
+int BasicLimitOrderBook<Levels, EventSink>::apply_insert(OrderSide side, Price price, int quantity,
+                                                         long long timestamp)
+{
+    Order order(next_order_id++, side, OrderType::LIMIT, price, quantity, timestamp);
+    events.on_order_accepted(OrderEvent{order.id, side, OrderType::LIMIT, price, quantity});
+    rest_order(order);
+    return order.id;
+}
 
-            if (!process_price_level(limit_order, queue, price, false))
-                break; // No more favorable prices
+template <typename Levels, typename EventSink>
+int BasicLimitOrderBook<Levels, EventSink>::apply_fill(int order_id, int quantity)
+{
+    if (quantity <= 0)
+        return -1;
 
-            if (queue.empty())
-                it = ask_levels.erase(it);
-            else
-                ++it;
-        }
+    Order **location = order_locations.find(order_id);
+    if (!location)
+        return -1;
 
-        // Add remaining quantity to bid book
-        if (limit_order->quantity > 0)
-        {
-            bid_levels[limit_order->price].add_order(limit_order);
-            order_locations[limit_order->id] = {limit_order->price, OrderSide::BUY};
-        }
+    Order *order = *location;
+    Levels &levels = order->side == OrderSide::BUY ? bid_levels : ask_levels;
+    OrderQueue *queue = levels.find(order->price);
+    if (!queue)
+        return -1;
+
+    if (queue->reduce_order(order, quantity))
+    {
+        emit_level(order->side, order->price, *queue);
+        return order->quantity;
     }
-    else
+
+    Price price = order->price;
+    queue->remove_order(order);
+    emit_level(order->side, price, *queue);
+    if (queue->empty())
+        levels.erase(price);
+
+    order_locations.erase(order_id);
+    order_pool.release(order);
+    return 0;
+}
+
+template <typename Levels, typename EventSink>
+void BasicLimitOrderBook<Levels, EventSink>::prefetch_index(const BookCommand &command) const
+{
+    switch (command.type)
     {
-        // Sell limit order - match against bids at or above limit price
-        auto it = bid_levels.begin();
-        while (limit_order->quantity > 0 && it != bid_levels.end())
-        {
-            auto &[price, queue] = *it;
+    case BookCommandType::CANCEL:
+    case BookCommandType::REDUCE:
+    case BookCommandType::FILL:
+        order_locations.prefetch(command.order_id);
+        break;
+    case BookCommandType::LIMIT:
+    case BookCommandType::INSERT:
+        (command.side == OrderSide::BUY ? bid_levels : ask_levels).prefetch(command.price);
+        break;
+    case BookCommandType::MARKET:
+        break;
+    }
+}
 
-            if (queue.empty())
-            {
-                it = bid_levels.erase(it);
-                continue;
-            }
+template <typename Levels, typename EventSink>
+void BasicLimitOrderBook<Levels, EventSink>::prefetch_order(const BookCommand &command) const
+{
+    if (command.type != BookCommandType::CANCEL && command.type != BookCommandType::REDUCE &&
+        command.type != BookCommandType::FILL)
+        return;
 
-            if (!process_price_level(limit_order, queue, price, false))
-                break; // No more favorable prices
+    // The handle may be stale by the time the command runs; a prefetch cannot fault
+    Order *const *location = order_locations.find(command.order_id);
+    if (location)
+        prefetch_memory(*location);
+}
 
-            if (queue.empty())
-                it = bid_levels.erase(it);
-            else
-                ++it;
-        }
+template <typename Levels, typename EventSink>
+int BasicLimitOrderBook<Levels, EventSink>::add_limit_order(OrderSide side, Price price, int quantity)
+{
+    LOB_MEASURE_LATENCY(latency, BookOperation::ADD_LIMIT);
+    return apply_limit(side, price, quantity, get_timestamp());
+}
 
-        // Add remaining quantity to ask book
-        if (limit_order->quantity > 0)
-        {
-            ask_levels[limit_order->price].add_order(limit_order);
-            order_locations[limit_order->id] = {limit_order->price, OrderSide::SELL};
-        }
-    }
+template <typename Levels, typename EventSink>
+void BasicLimitOrderBook<Levels, EventSink>::add_market_order(OrderSide side, int quantity)
+{
+    LOB_MEASURE_LATENCY(latency, BookOperation::ADD_MARKET);
+    apply_market(side, quantity, get_timestamp());
 }
 
-int LimitOrderBook::add_limit_order(OrderSide side, double price, int quantity)
+template <typename Levels, typename EventSink>
+bool BasicLimitOrderBook<Levels, EventSink>::cancel_order(int order_id)
 {
-    auto order = std::make_shared<Order>(next_order_id++, side, OrderType::LIMIT,
-                                         price, quantity, get_timestamp());
-    match_limit_order(order);
-    return order->id;
+    LOB_MEASURE_LATENCY(latency, BookOperation::CANCEL);
+    return apply_cancel(order_id);
 }
 
-void LimitOrderBook::add_market_order(OrderSide side, int quantity)
+template <typename Levels, typename EventSink>
+int BasicLimitOrderBook<Levels, EventSink>::reduce_order(int order_id, int quantity)
 {
-    auto order = std::make_shared<Order>(next_order_id++, side, OrderType::MARKET,
-                                         0.0, quantity, get_timestamp());
-    match_market_order(order);
+    LOB_MEASURE_LATENCY(latency, BookOperation::REDUCE);
+    return apply_reduce(order_id, quantity);
 }
 
-bool LimitOrderBook::cancel_order(int order_id)
+template <typename Levels, typename EventSink>
+int BasicLimitOrderBook<Levels, EventSink>::insert_order(OrderSide side, Price price, int quantity)
 {
-    auto it = order_locations.find(order_id);
-    if (it == order_locations.end())
-        return false;
+    LOB_MEASURE_LATENCY(latency, BookOperation::INSERT);
+    return apply_insert(side, price, quantity, get_timestamp());
+}
 
-    double price = it->second.first;
-    OrderSide side = it->second.second;
+template <typename Levels, typename EventSink>
+int BasicLimitOrderBook<Levels, EventSink>::fill_order(int order_id, int quantity)
+{
+    LOB_MEASURE_LATENCY(latency, BookOperation::FILL);
+    return apply_fill(order_id, quantity);
+}
 
-    bool found = false;
-    if (side == OrderSide::BUY)
-    {
-        auto level_it = bid_levels.find(price);
-        if (level_it != bid_levels.end())
-        {
-            found = level_it->second.remove_order(order_id);
-            if (level_it->second.empty())
-                bid_levels.erase(level_it);
-        }
-    }
-    else
+template <typename Levels, typename EventSink>
+void BasicLimitOrderBook<Levels, EventSink>::process_batch(const BookCommand *commands, size_t count,
+                                                           int *results)
+{
+    long long timestamp = get_timestamp();
+
+    // Warm the first commands' lookups before the loop starts its own look-ahead
+    for (size_t i = 0; i < count && i < 2 * BATCH_PREFETCH_DISTANCE; i++)
+        prefetch_index(commands[i]);
+    for (size_t i = 0; i < count && i < BATCH_PREFETCH_DISTANCE; i++)
+        prefetch_order(commands[i]);
+
+    for (size_t i = 0; i < count; i++)
     {
-        auto level_it = ask_levels.find(price);
-        if (level_it != ask_levels.end())
+        // Two stages: index slots and levels far ahead, then the orders those slots point to
+        if (i + 2 * BATCH_PREFETCH_DISTANCE < count)
+            prefetch_index(commands[i + 2 * BATCH_PREFETCH_DISTANCE]);
+        if (i + BATCH_PREFETCH_DISTANCE < count)
+            prefetch_order(commands[i + BATCH_PREFETCH_DISTANCE]);
+
+        const BookCommand &command = commands[i];
+        LOB_MEASURE_LATENCY(latency, to_book_operation(command.type));
+        switch (command.type)
         {
-            found = level_it->second.remove_order(order_id);
-            if (level_it->second.empty())
-                ask_levels.erase(level_it);
+        case BookCommandType::LIMIT:
+            results[i] = apply_limit(command.side, command.price, command.quantity, timestamp);
+            break;
+        case BookCommandType::MARKET:
+            apply_market(command.side, command.quantity, timestamp);
+            results[i] = 0;
+            break;
+        case BookCommandType::CANCEL:
+            results[i] = apply_cancel(command.order_id) ? 1 : 0;
+            break;
+        case BookCommandType::REDUCE:
+            results[i] = apply_reduce(command.order_id, command.quantity);
+            break;
+        case BookCommandType::INSERT:
+            results[i] = apply_insert(command.side, command.price, command.quantity, timestamp);
+            break;
+        case BookCommandType::FILL:
+            results[i] = apply_fill(command.order_id, command.quantity);
+            break;
         }
     }
+}
 
-    if (found)
-        order_locations.erase(it);
+template <typename Levels, typename EventSink>
+int BasicLimitOrderBook<Levels, EventSink>::get_next_order_id() const
+{
+    return next_order_id;
+}
 
-    return found;
+template <typename Levels, typename EventSink>
+void BasicLimitOrderBook<Levels, EventSink>::configure_order_index(IdIndexMode mode, size_t expected_orders)
+{
+    order_locations.configure(mode, expected_orders);
 }
 
-void LimitOrderBook::print_book() const
+template <typename Levels, typename EventSink>
+EventSink &BasicLimitOrderBook<Levels, EventSink>::get_event_sink()
+{
+    return events;
+}
+
+template <typename Levels, typename EventSink>
+const OrderPool &BasicLimitOrderBook<Levels, EventSink>::get_order_pool() const
+{
+    return order_pool;
+}
+
+template <typename Levels, typename EventSink>
+const LatencyTable &BasicLimitOrderBook<Levels, EventSink>::get_latency() const
+{
+    return latency;
+}
+
+template <typename Levels, typename EventSink>
+void BasicLimitOrderBook<Levels, EventSink>::print_book() const
 {
     std::cout << "\n=== ORDER BOOK ===" << std::endl;
 
@@ -246,12 +443,9 @@ void LimitOrderBook::print_book() const
     // Best ask
     if (!ask_levels.empty())
     {
-        auto &[ask_price, ask_queue] = *ask_levels.begin();
-        if (!ask_queue.empty())
-        {
-            std::cout << "Best Ask: $" << std::fixed << std::setprecision(2)
-                      << ask_price << " (" << ask_queue.get_total_quantity() << " shares)" << std::endl;
-        }
+        std::cout << "Best Ask: $" << std::fixed << std::setprecision(2)
+                  << price_to_double(ask_levels.best_price()) << " ("
+                  << ask_levels.best_level().get_total_quantity() << " shares)" << std::endl;
     }
     else
         std::cout << "Best Ask: No asks available" << std::endl;
@@ -259,12 +453,9 @@ void LimitOrderBook::print_book() const
     // Best bid
     if (!bid_levels.empty())
     {
-        auto &[bid_price, bid_queue] = *bid_levels.begin();
-        if (!bid_queue.empty())
-        {
-            std::cout << "Best Bid: $" << std::fixed << std::setprecision(2)
-                      << bid_price << " (" << bid_queue.get_total_quantity() << " shares)" << std::endl;
-        }
+        std::cout << "Best Bid: $" << std::fixed << std::setprecision(2)
+                  << price_to_double(bid_levels.best_price()) << " ("
+                  << bid_levels.best_level().get_total_quantity() << " shares)" << std::endl;
     }
     else
         std::cout << "Best Bid: No bids available" << std::endl;
@@ -272,11 +463,188 @@ void LimitOrderBook::print_book() const
     // Spread calculation
     if (!bid_levels.empty() && !ask_levels.empty())
     {
-        auto &[bid_price, _] = *bid_levels.begin();
-        auto &[ask_price, __] = *ask_levels.begin();
-        double spread = ask_price - bid_price;
-        std::cout << "Spread: $" << std::fixed << std::setprecision(2) << spread << std::endl;
+        Price spread = ask_levels.best_price() - bid_levels.best_price();
+        std::cout << "Spread: $" << std::fixed << std::setprecision(2)
+                  << price_to_double(spread) << std::endl;
     }
 
     std::cout << "==================" << std::endl;
-}
\ No newline at end of file
+}
+
+template <typename Levels, typename EventSink>
+size_t BasicLimitOrderBook<Levels, EventSink>::get_depth(DepthLevel *out, size_t levels) const
+{
+    size_t asks = ask_levels.visit_levels(levels, [out, i = size_t(0)](Price price, const OrderQueue &queue) mutable
+                                          {
+        out[i].ask_price = price;
+        out[i].ask_size = queue.get_total_quantity();
+        i++; });
+    size_t bids = bid_levels.visit_levels(levels, [out, i = size_t(0)](Price price, const OrderQueue &queue) mutable
+                                          {
+        out[i].bid_price = price;
+        out[i].bid_size = queue.get_total_quantity();
+        i++; });
+
+    for (size_t i = asks; i < levels; i++)
+    {
+        out[i].ask_price = LOBSTER_EMPTY_ASK_PRICE;
+        out[i].ask_size = 0;
+    }
+    for (size_t i = bids; i < levels; i++)
+    {
+        out[i].bid_price = LOBSTER_EMPTY_BID_PRICE;
+        out[i].bid_size = 0;
+    }
+
+    return std::max(asks, bids);
+}
+
+template <typename Levels, typename EventSink>
+bool BasicLimitOrderBook<Levels, EventSink>::save_state(std::ostream &out) const
+{
+    BookSnapshotHeader header{};
+    std::memcpy(header.magic, BOOK_SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = BOOK_SNAPSHOT_VERSION;
+    header.record_size = sizeof(BookSnapshotRecord);
+    header.next_order_id = next_order_id;
+    header.order_count = order_locations.size();
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    std::vector<BookSnapshotRecord> batch;
+    batch.reserve(BOOK_SNAPSHOT_BATCH);
+    auto flush = [&]
+    {
+        out.write(reinterpret_cast<const char *>(batch.data()),
+                  static_cast<std::streamsize>(batch.size() * sizeof(BookSnapshotRecord)));
+        batch.clear();
+    };
+
+    for_each_order([&](const Order &order)
+                   {
+        BookSnapshotRecord record{};
+        record.price = order.price;
+        record.timestamp = order.timestamp;
+        record.id = order.id;
+        record.quantity = order.quantity;
+        record.side = order.side == OrderSide::BUY ? 1 : -1;
+        batch.push_back(record);
+        if (batch.size() == BOOK_SNAPSHOT_BATCH)
+            flush(); });
+    flush();
+
+    return static_cast<bool>(out);
+}
+
+template <typename Levels, typename EventSink>
+bool BasicLimitOrderBook<Levels, EventSink>::load_state(std::istream &in)
+{
+    auto clear_book = [this]
+    {
+        bid_levels = Levels(OrderSide::BUY);
+        ask_levels = Levels(OrderSide::SELL);
+        order_pool = OrderPool();
+        order_locations.clear();
+        next_order_id = 1;
+    };
+    clear_book();
+
+    BookSnapshotHeader header;
+    if (!in.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, BOOK_SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != BOOK_SNAPSHOT_VERSION || header.record_size != sizeof(BookSnapshotRecord) ||
+        header.next_order_id < 1 || header.next_order_id > INT_MAX ||
+        header.order_count > static_cast<uint64_t>(header.next_order_id) ||
+        header.order_count > snapshot_bytes_left(in) / sizeof(BookSnapshotRecord))
+    {
+        return false;
+    }
+
+    // Size everything once up front; DENSE indexes are sized by id rather than by count
+    size_t count = static_cast<size_t>(header.order_count);
+    order_pool.reserve(count);
+    order_locations.configure(order_locations.get_mode(),
+                              order_locations.get_mode() == IdIndexMode::DENSE
+                                  ? static_cast<size_t>(header.next_order_id)
+                                  : count);
+    next_order_id = static_cast<int>(header.next_order_id);
+
+    std::vector<BookSnapshotRecord> batch(std::min(count, BOOK_SNAPSHOT_BATCH));
+    for (size_t loaded = 0; loaded < count;)
+    {
+        size_t n = std::min(count - loaded, batch.size());
+        if (!in.read(reinterpret_cast<char *>(batch.data()),
+                     static_cast<std::streamsize>(n * sizeof(BookSnapshotRecord))))
+            break;
+
+        for (size_t i = 0; i < n; i++)
+        {
+            // Ids must be ones the restored counter has handed out, once each, and every
+            // order must add to its level's total
+            const BookSnapshotRecord &record = batch[i];
+            if (record.id < 1 || record.id >= next_order_id || record.quantity <= 0 ||
+                (record.side != 1 && record.side != -1) || order_locations.find(record.id))
+            {
+                clear_book();
+                return false;
+            }
+
+            OrderSide side = record.side > 0 ? OrderSide::BUY : OrderSide::SELL;
+            Order *resting = order_pool.allocate(Order(record.id, side, OrderType::LIMIT, record.price,
+                                                       record.quantity, record.timestamp));
+            Levels &own = side == OrderSide::BUY ? bid_levels : ask_levels;
+            own.get_or_create(resting->price).add_order(resting);
+            order_locations.insert(resting->id, resting);
+        }
+        loaded += n;
+    }
+
+    // A short read
+    if (order_locations.size() != count)
+    {
+        clear_book();
+        return false;
+    }
+    return true;
+}
+
+template <typename Levels, typename EventSink>
+void BasicLimitOrderBook<Levels, EventSink>::print_depth(size_t levels) const
+{
+    std::vector<DepthLevel> depth(levels);
+    size_t present = get_depth(depth.data(), levels);
+
+    std::cout << "\n=== MARKET DEPTH ===" << std::endl;
+    if (present == 0)
+    {
+        std::cout << "Book is empty" << std::endl;
+        return;
+    }
+
+    std::cout << std::left << std::setw(7) << "Level" << std::right << std::setw(12) << "Bid Size"
+              << std::setw(12) << "Bid" << std::setw(12) << "Ask" << std::setw(12) << "Ask Size" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    for (size_t i = 0; i < present; i++)
+    {
+        const DepthLevel &level = depth[i];
+        std::cout << std::left << std::setw(7) << i + 1 << std::right;
+        if (level.bid_size > 0)
+            std::cout << std::setw(12) << level.bid_size << std::setw(12) << price_to_double(level.bid_price);
+        else
+            std::cout << std::setw(12) << "-" << std::setw(12) << "-";
+        if (level.ask_size > 0)
+            std::cout << std::setw(12) << price_to_double(level.ask_price) << std::setw(12) << level.ask_size;
+        else
+            std::cout << std::setw(12) << "-" << std::setw(12) << "-";
+        std::cout << std::endl;
+    }
+    std::cout << "====================" << std::endl;
+}
+
+template class BasicLimitOrderBook<MapPriceLevels, NullEventSink>;
+template class BasicLimitOrderBook<MapPriceLevels, PrintingEventSink>;
+template class BasicLimitOrderBook<MapPriceLevels, TradeRecorder>;
+template class BasicLimitOrderBook<MapPriceLevels, MarketDataSink>;
+template class BasicLimitOrderBook<LadderPriceLevels, NullEventSink>;
+template class BasicLimitOrderBook<LadderPriceLevels, PrintingEventSink>;
+template class BasicLimitOrderBook<LadderPriceLevels, TradeRecorder>;
+template class BasicLimitOrderBook<LadderPriceLevels, MarketDataSink>;
@@ -1,87 +1,243 @@
 #ifndef LOB_H
 #define LOB_H
 
+#include "latency_stats.h"
+#include "lob_events.h"
 #include "order.h"
+#include "order_id_index.h"
+#include "order_pool.h"
 #include "order_queue.h"
-#include <map>
-#include <unordered_map>
-#include <memory>
+#include "price_levels.h"
+#include <cstddef>
+#include <iosfwd>
 
 /**
- * @class LimitOrderBook
+ * @enum BookOperation
+ * @brief Public book operations whose latency is recorded when built with LATENCY=on.
+ */
+enum class BookOperation
+{
+    ADD_LIMIT,  /** add_limit_order */
+    ADD_MARKET, /** add_market_order */
+    CANCEL,     /** cancel_order */
+    REDUCE,     /** reduce_order */
+    INSERT,     /** insert_order */
+    FILL        /** fill_order */
+};
+
+/**
+ * @enum BookCommandType
+ * @brief Operation of a BookCommand.
+ */
+enum class BookCommandType : uint8_t
+{
+    LIMIT,  /** add_limit_order; the result is the new order id */
+    MARKET, /** add_market_order; the result is 0 */
+    CANCEL, /** cancel_order; the result is 1 if the order was cancelled, 0 otherwise */
+    REDUCE, /** reduce_order; the result is its return value */
+    INSERT, /** insert_order; the result is the new order id */
+    FILL    /** fill_order; the result is its return value */
+};
+
+/**
+ * @brief Maps a command type to the operation its latency is recorded under.
+ * @param type The command type.
+ * @return The matching BookOperation.
+ */
+inline BookOperation to_book_operation(BookCommandType type)
+{
+    switch (type)
+    {
+    case BookCommandType::LIMIT:
+        return BookOperation::ADD_LIMIT;
+    case BookCommandType::MARKET:
+        return BookOperation::ADD_MARKET;
+    case BookCommandType::CANCEL:
+        return BookOperation::CANCEL;
+    case BookCommandType::REDUCE:
+        return BookOperation::REDUCE;
+    case BookCommandType::INSERT:
+        return BookOperation::INSERT;
+    case BookCommandType::FILL:
+        break;
+    }
+    return BookOperation::FILL;
+}
+
+/**
+ * @struct BookCommand
+ * @brief One operation submitted to BasicLimitOrderBook::process_batch.
+ */
+struct BookCommand
+{
+    BookCommandType type; // Operation to apply
+    OrderSide side;       // Side of LIMIT, MARKET and INSERT orders
+    int order_id;         // Target of CANCEL, REDUCE and FILL
+    int quantity;         // Quantity of every command but CANCEL
+    Price price;          // Limit price of LIMIT and INSERT orders in ticks
+};
+
+/**
+ * @struct DepthLevel
+ * @brief One level of an L2 depth snapshot, laid out like a LOBSTER orderbook file.
+ *
+ * An array of N DepthLevels has the same column order as a row of LOBSTER's
+ * orderbook_*_N.csv: ask price, ask size, bid price, bid size for level 1, then level 2...
+ */
+struct DepthLevel
+{
+    Price ask_price; // Ask price in ticks, LOBSTER_EMPTY_ASK_PRICE if there is no such level
+    int ask_size;    // Total ask quantity at the level
+    Price bid_price; // Bid price in ticks, LOBSTER_EMPTY_BID_PRICE if there is no such level
+    int bid_size;    // Total bid quantity at the level
+};
+
+/** Price LOBSTER writes for a missing ask level (with size 0). */
+constexpr Price LOBSTER_EMPTY_ASK_PRICE = 9999999999;
+
+/** Price LOBSTER writes for a missing bid level (with size 0). */
+constexpr Price LOBSTER_EMPTY_BID_PRICE = -9999999999;
+
+/**
+ * @class BasicLimitOrderBook
  * @brief Manages a limit order book for matching buy and sell orders.
  *
  * This class implements a limit order book (LOB) that maintains bid and ask price levels,
  * tracks orders by ID, and processes limit and market orders. It supports adding, canceling,
  * and matching orders, as well as printing the current state of the book.
+ *
+ * Everything the book does is reported to an event sink that is bound at compile time,
+ * so the default NullEventSink costs nothing and output is entirely up to the caller.
+ *
+ * @tparam Levels The price level store used for each side of the book
+ *                (MapPriceLevels or LadderPriceLevels).
+ * @tparam EventSink Receives trade, order and level events (see lob_events.h).
  */
-class LimitOrderBook
+template <typename Levels, typename EventSink = NullEventSink>
+class BasicLimitOrderBook
 {
+public:
+    /** Commands process_batch looks ahead when prefetching orders; index slots are prefetched twice as far. */
+    static constexpr size_t BATCH_PREFETCH_DISTANCE = 8;
+
 private:
-    // Price level maps: price -> OrderQueue
-    // Buy orders (descending price)
-    std::map<double, OrderQueue> bid_levels;
-    // Sell orders (ascending price)
-    std::map<double, OrderQueue, std::greater<double>> ask_levels;
+    // Price level stores: price (ticks) -> OrderQueue
+    // Buy orders (best = highest price)
+    Levels bid_levels;
+    // Sell orders (best = lowest price)
+    Levels ask_levels;
 
-    // Order ID tracking
-    std::unordered_map<int, std::pair<double, OrderSide>> order_locations;
+    // Storage for resting orders
+    OrderPool order_pool;
+
+    // Order ID -> resting order handle
+    OrderIdIndex<Order *> order_locations;
 
     int next_order_id;
 
+    // Receiver of trade, order and level events
+    EventSink events;
+
+    // Latency histograms indexed by BookOperation (empty unless built with LATENCY=on)
+    LatencyTable latency;
+
     /**
      * @brief Retrieves the current timestamp.
      * @return The current timestamp as a long long value.
      */
     long long get_timestamp();
 
+    /**
+     * @brief Reports the current aggregate state of a price level to the event sink.
+     * @param side The side of the level.
+     * @param price The level price in ticks.
+     * @param queue The level's order queue (empty if the level is being removed).
+     */
+    void emit_level(OrderSide side, Price price, const OrderQueue &queue);
+
     /**
      * @brief Executes a trade between an aggressive and a passive order.
      * @param aggressive_order The order initiating the trade.
      * @param passive_order The order being matched against.
      * @param trade_quantity The quantity to be traded.
      */
-    void execute_trade(std::shared_ptr<Order> aggressive_order,
-                       std::shared_ptr<Order> passive_order,
+    void execute_trade(const Order &aggressive_order,
+                       const Order &passive_order,
                        int trade_quantity);
 
     /**
      * @brief Processes matching at a single price level.
      * @param order The order being matched.
      * @param queue The order queue at the current price level.
-     * @param level_price The price of the current level.
+     * @param level_price The price of the current level in ticks.
      * @param is_market_order Whether this is a market order.
      * @return True to continue processing other levels, false to stop.
      */
-    bool process_price_level(std::shared_ptr<Order> order, OrderQueue &queue,
-                             double level_price, bool is_market_order);
+    bool process_price_level(Order &order, OrderQueue &queue,
+                             Price level_price, bool is_market_order);
+
+    /**
+     * @brief Matches an order against the opposite side of the book, best level first.
+     * @param order The order being matched.
+     * @param levels The opposite side's level store.
+     * @param is_market_order Whether this is a market order.
+     */
+    void match_against(Order &order, Levels &levels, bool is_market_order);
+
+    /**
+     * @brief Moves an order into the pool and queues it at its price level.
+     * @param order The order to rest; its quantity must be positive.
+     */
+    void rest_order(const Order &order);
+
+    // Unmeasured operations behind the public calls and process_batch; the adds take
+    // the order timestamp so a batch reads the clock once
+
+    int apply_limit(OrderSide side, Price price, int quantity, long long timestamp);
+    void apply_market(OrderSide side, int quantity, long long timestamp);
+    bool apply_cancel(int order_id);
+    int apply_reduce(int order_id, int quantity);
+    int apply_insert(OrderSide side, Price price, int quantity, long long timestamp);
+    int apply_fill(int order_id, int quantity);
+
+    /**
+     * @brief Starts loading the id index slot or price level a command will look up first.
+     * @param command An upcoming command.
+     */
+    void prefetch_index(const BookCommand &command) const;
+
+    /**
+     * @brief Starts loading the resting order a command targets, if it has one.
+     * @param command An upcoming command whose index slot should already be cached.
+     */
+    void prefetch_order(const BookCommand &command) const;
 
     /**
      * @brief Matches a market order against available limit orders.
      * @param market_order The market order to be matched.
      */
-    void match_market_order(std::shared_ptr<Order> market_order);
+    void match_market_order(Order &market_order);
 
     /**
      * @brief Matches a limit order against available orders in the book.
      * @param limit_order The limit order to be matched.
      */
-    void match_limit_order(std::shared_ptr<Order> limit_order);
+    void match_limit_order(Order &limit_order);
 
 public:
     /**
-     * @brief Constructs a new LimitOrderBook instance.
+     * @brief Constructs a new BasicLimitOrderBook instance.
      */
-    LimitOrderBook();
+    BasicLimitOrderBook();
 
     /**
      * @brief Adds a limit order to the book.
      * @param side The side of the order (buy or sell).
-     * @param price The limit price of the order.
+     * @param price The limit price of the order in ticks.
      * @param quantity The quantity of the order.
      * @return The unique order ID assigned to the new order.
      */
-    int add_limit_order(OrderSide side, double price, int quantity);
+    int add_limit_order(OrderSide side, Price price, int quantity);
 
     /**
      * @brief Adds a market order to the book.
@@ -97,10 +253,191 @@ public:
      */
     bool cancel_order(int order_id);
 
+    /**
+     * @brief Reduces a resting order's quantity in place, keeping its queue priority.
+     *
+     * The order and its level total are decremented in O(1); the sink sees the reduced
+     * quantity as a cancel of that quantity and the level's new state. Reducing by the
+     * whole remaining quantity or more cancels the order.
+     * @param order_id The unique ID of the order to reduce.
+     * @param quantity The quantity to remove (must be positive).
+     * @return The quantity left resting (0 if the order was removed), or -1 if there is no such
+     *         order or the quantity is not positive.
+     */
+    int reduce_order(int order_id, int quantity);
+
+    /**
+     * @brief Rests a limit order without matching it, for rebuilding a book from exchange data.
+     *
+     * Historical adds never crossed the book they were sent to, so there is nothing to match;
+     * the caller is trusted to keep the book uncrossed.
+     * @param side The side of the order (buy or sell).
+     * @param price The limit price of the order in ticks.
+     * @param quantity The quantity of the order.
+     * @return The unique order ID assigned to the new order.
+     */
+    int insert_order(OrderSide side, Price price, int quantity);
+
+    /**
+     * @brief Applies an exchange-reported execution directly to a resting order.
+     *
+     * No price levels are walked: the order is reduced in place through its handle and
+     * removed once fully filled. The sink sees the level change but no trade, since the
+     * trade happened at the exchange rather than in this book.
+     * @param order_id The unique ID of the executed resting order.
+     * @param quantity The executed quantity (must be positive).
+     * @return The quantity left resting (0 if the order was filled), or -1 if there is no such
+     *         order or the quantity is not positive.
+     */
+    int fill_order(int order_id, int quantity);
+
+    /**
+     * @brief Applies a run of commands in order, as if each were a separate call.
+     *
+     * The book ends up exactly as after the equivalent sequence of calls and the sink
+     * sees the same events, but the clock is read once (every order in the batch gets
+     * the same timestamp) and the id index slots, price levels and resting orders of
+     * upcoming commands are prefetched while earlier ones execute.
+     * @param commands The commands, applied first to last.
+     * @param count Number of commands.
+     * @param results Buffer of at least `count` entries receiving each command's result
+     *                (see BookCommandType).
+     */
+    void process_batch(const BookCommand *commands, size_t count, int *results);
+
+    /**
+     * @brief Gets the id the next limit, market or inserted order will be assigned.
+     *
+     * Ids are handed out sequentially, so a caller building a batch can predict the
+     * ids of the orders it adds and refer to them later in the same batch.
+     * @return The next order id.
+     */
+    int get_next_order_id() const;
+
+    /**
+     * @brief Chooses the storage strategy of the order id index and pre-sizes it.
+     *
+     * Internal ids are handed out sequentially, so DENSE mode is always valid; it trades
+     * memory proportional to every id ever issued for probe-free lookups.
+     * Must be called while the book holds no orders.
+     * @param mode The index storage strategy.
+     * @param expected_orders Number of resting orders (HASHED) or ids (DENSE) to size for.
+     */
+    void configure_order_index(IdIndexMode mode, size_t expected_orders);
+
+    /**
+     * @brief Gets the event sink the book reports to.
+     * @return The book's event sink.
+     */
+    EventSink &get_event_sink();
+
+    /**
+     * @brief Gets the pool that stores resting orders, for usage statistics.
+     * @return The book's order pool.
+     */
+    const OrderPool &get_order_pool() const;
+
+    /**
+     * @brief Gets the per-operation latency histograms.
+     *
+     * Only populated when built with LATENCY=on; otherwise the table is an empty stub.
+     * @return The book's latency table, indexed by BookOperation.
+     */
+    const LatencyTable &get_latency() const;
+
+    /**
+     * @brief Copies the top levels of both sides into a caller-provided buffer.
+     *
+     * Level totals are kept up to date by every add, cancel and fill, so this reads
+     * `levels` aggregates per side and never allocates. Missing levels are filled with
+     * LOBSTER's placeholder prices and zero size.
+     * @param out Buffer of at least `levels` entries, level 1 first.
+     * @param levels Number of levels to write.
+     * @return The number of levels present on the deeper side.
+     */
+    size_t get_depth(DepthLevel *out, size_t levels) const;
+
+    /**
+     * @brief Calls a visitor on every resting order, bids then asks, in priority order.
+     * @param visit Callable as visit(const Order&).
+     */
+    template <typename Visitor>
+    void for_each_order(Visitor &&visit) const;
+
+    /**
+     * @brief Writes every resting order and the id counter as a binary snapshot.
+     *
+     * The format is described in book_snapshot.h; orders are streamed in batches
+     * without building a copy of the book.
+     * @param out Binary stream to write to.
+     * @return True if everything was written.
+     */
+    bool save_state(std::ostream &out) const;
+
+    /**
+     * @brief Replaces the book's contents with a snapshot written by save_state.
+     *
+     * The pool and the id index are sized for the whole snapshot before the first order
+     * is placed, and orders are read in batches and appended in priority order, so
+     * loading costs one pass over the file. No events are emitted; consumers of level
+     * updates must resynchronize from a depth snapshot. The index keeps its mode.
+     * @param in Binary stream to read from.
+     * @return False if the snapshot is malformed or truncated, or any order in it is invalid
+     *         (an id outside the restored counter or repeated, a non-positive quantity, an
+     *         unknown side); the book is then left empty.
+     */
+    bool load_state(std::istream &in);
+
     /**
      * @brief Prints the current state of the order book.
      */
     void print_book() const;
+
+    /**
+     * @brief Prints the top levels of both sides as a ladder.
+     * @param levels Number of levels per side to print.
+     */
+    void print_depth(size_t levels) const;
 };
 
-#endif // LOB_H
\ No newline at end of file
+template <typename Levels, typename EventSink>
+template <typename Visitor>
+void BasicLimitOrderBook<Levels, EventSink>::for_each_order(Visitor &&visit) const
+{
+    auto visit_side = [&](const Levels &levels)
+    {
+        levels.visit_levels(SIZE_MAX, [&](Price, const OrderQueue &queue)
+                            {
+                                for (const Order *order = queue.front(); order; order = order->next)
+                                    visit(*order);
+                            });
+    };
+    visit_side(bid_levels);
+    visit_side(ask_levels);
+}
+
+// Every level store / event sink combination is compiled once in lob.cpp
+extern template class BasicLimitOrderBook<MapPriceLevels, NullEventSink>;
+extern template class BasicLimitOrderBook<MapPriceLevels, PrintingEventSink>;
+extern template class BasicLimitOrderBook<MapPriceLevels, TradeRecorder>;
+extern template class BasicLimitOrderBook<LadderPriceLevels, NullEventSink>;
+extern template class BasicLimitOrderBook<LadderPriceLevels, PrintingEventSink>;
+extern template class BasicLimitOrderBook<LadderPriceLevels, TradeRecorder>;
+
+/** Order book backed by std::map price levels. */
+using MapLimitOrderBook = BasicLimitOrderBook<MapPriceLevels>;
+
+/** Order book backed by the tick-indexed array ladder. */
+using LadderLimitOrderBook = BasicLimitOrderBook<LadderPriceLevels>;
+
+// The simulator's level store; build with LEVELS=ladder to switch the whole program over
+#ifdef LOB_LADDER_LEVELS
+using DefaultPriceLevels = LadderPriceLevels;
+#else
+using DefaultPriceLevels = MapPriceLevels;
+#endif
+
+/** The simulator's silent order book. */
+using LimitOrderBook = BasicLimitOrderBook<DefaultPriceLevels>;
+
+#endif // LOB_H
@@ -0,0 +1,45 @@
+#include "lob_events.h"
+#include <iostream>
+#include <iomanip>
+
+void print_trade(const TradeEvent &trade)
+{
+    std::cout << "TRADE: " << trade.quantity << " shares at $"
+              << std::fixed << std::setprecision(2) << price_to_double(trade.price) << '\n';
+}
+
+void PrintingEventSink::on_trade(const TradeEvent &trade)
+{
+    print_trade(trade);
+}
+
+void PrintingEventSink::on_order_cancelled(const OrderEvent &order)
+{
+    // Explicit cancels are reported by the caller; only unfilled market remainders are news
+    if (order.type == OrderType::MARKET)
+    {
+        std::cout << "WARNING: Market order partially filled. "
+                  << order.quantity << " shares remain unfilled." << std::endl;
+    }
+}
+
+TradeRecorder::TradeRecorder(size_t capacity) : dropped(0)
+{
+    trades.reserve(capacity);
+}
+
+const std::vector<TradeEvent> &TradeRecorder::get_trades() const
+{
+    return trades;
+}
+
+size_t TradeRecorder::get_dropped() const
+{
+    return dropped;
+}
+
+void TradeRecorder::clear()
+{
+    trades.clear();
+    dropped = 0;
+}
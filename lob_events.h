@@ -0,0 +1,143 @@
+#ifndef LOB_EVENTS_H
+#define LOB_EVENTS_H
+
+#include "order.h"
+#include <cstddef>
+#include <vector>
+
+/**
+ * @struct TradeEvent
+ * @brief A fill between an incoming (aggressive) order and a resting (passive) order.
+ */
+struct TradeEvent
+{
+    int aggressive_order_id; // Order that initiated the trade
+    int passive_order_id;    // Resting order that was hit
+    OrderSide aggressor_side; // Side of the aggressive order
+    Price price;             // Execution price in ticks (the passive order's price)
+    int quantity;            // Number of shares traded
+    long long timestamp;     // Timestamp of the aggressive order
+};
+
+/**
+ * @struct OrderEvent
+ * @brief A change in an order's lifecycle (accepted, rested or cancelled).
+ */
+struct OrderEvent
+{
+    int order_id;   // Order the event refers to
+    OrderSide side; // Side of the order
+    OrderType type; // Type of the order
+    Price price;    // Limit price in ticks (0 for market orders)
+    int quantity;   // Quantity accepted, rested or cancelled
+};
+
+/**
+ * @struct LevelEvent
+ * @brief The new aggregate state of a price level after it changed.
+ */
+struct LevelEvent
+{
+    OrderSide side;     // Side of the book the level is on
+    Price price;        // Level price in ticks
+    int total_quantity; // Aggregate resting quantity (0 once the level is gone)
+    size_t order_count; // Number of resting orders at the level
+};
+
+/**
+ * @struct NullEventSink
+ * @brief Event sink that ignores every event.
+ *
+ * The book calls its sink through the template parameter, so these empty inline
+ * handlers compile away entirely. Other sinks can derive from this one and hide
+ * only the handlers they care about.
+ */
+struct NullEventSink
+{
+    void on_order_accepted(const OrderEvent &) {}
+    void on_trade(const TradeEvent &) {}
+    void on_order_rested(const OrderEvent &) {}
+    void on_order_cancelled(const OrderEvent &) {}
+    void on_level_changed(const LevelEvent &) {}
+};
+
+/**
+ * @struct PrintingEventSink
+ * @brief Event sink that prints trades and unfilled market orders for the interactive CLI.
+ */
+struct PrintingEventSink : NullEventSink
+{
+    /**
+     * @brief Prints a trade.
+     * @param trade The trade to print.
+     */
+    void on_trade(const TradeEvent &trade);
+
+    /**
+     * @brief Prints a warning when a market order could not be completely filled.
+     * @param order The cancelled order or unfilled market remainder.
+     */
+    void on_order_cancelled(const OrderEvent &order);
+};
+
+/**
+ * @class TradeRecorder
+ * @brief Event sink that records trades into a preallocated buffer.
+ *
+ * The buffer never grows once constructed; trades arriving while it is full are
+ * counted as dropped, so recording never allocates on the matching path.
+ */
+class TradeRecorder : public NullEventSink
+{
+public:
+    /** Default number of trades the buffer can hold. */
+    static constexpr size_t DEFAULT_CAPACITY = 1 << 16;
+
+private:
+    std::vector<TradeEvent> trades; // Recorded trades, oldest first
+    size_t dropped;                 // Trades lost because the buffer was full
+
+public:
+    /**
+     * @brief Constructs a recorder with a fixed capacity.
+     * @param capacity Maximum number of trades held before dropping.
+     */
+    explicit TradeRecorder(size_t capacity = DEFAULT_CAPACITY);
+
+    /**
+     * @brief Records a trade, or counts it as dropped if the buffer is full.
+     * @param trade The trade to record.
+     */
+    void on_trade(const TradeEvent &trade)
+    {
+        if (trades.size() < trades.capacity())
+            trades.push_back(trade);
+        else
+            dropped++;
+    }
+
+    /**
+     * @brief Gets the recorded trades.
+     * @return The trades recorded since the last clear, oldest first.
+     */
+    const std::vector<TradeEvent> &get_trades() const;
+
+    /**
+     * @brief Gets the number of trades dropped because the buffer was full.
+     * @return The number of dropped trades.
+     */
+    size_t get_dropped() const;
+
+    /**
+     * @brief Empties the buffer without releasing its storage.
+     */
+    void clear();
+};
+
+/**
+ * @brief Prints a trade in the simulator's "TRADE: ..." format.
+ * @param trade The trade to print.
+ */
+void print_trade(const TradeEvent &trade);
+
+#endif // LOB_EVENTS_H
@@ -0,0 +1,1577 @@
+#include "book_snapshot.h"
+#include "lob.h"
+#include "lobster_cache.h"
+#include "lobster_parser.h"
+#include "lobster_replay.h"
+#include "order_gateway.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Behavioural tests of the order book, the order gateway and the LOBSTER pipeline:
+//
+//   make test
+//
+// Every failed check is printed with its location; the exit code is the number of failures.
+
+namespace
+{
+    int failures = 0;
+
+// Written to stderr directly, so failures show even while a test captures std::cerr
+#define CHECK(condition)                                                                       \
+    do                                                                                         \
+    {                                                                                          \
+        if (!(condition))                                                                      \
+        {                                                                                      \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                                        \
+        }                                                                                      \
+    } while (false)
+
+    // Library code reports progress on std::cout; keep it out of the test output
+    class SilenceStdout
+    {
+    private:
+        std::ostringstream sink;
+        std::streambuf *saved;
+
+    public:
+        SilenceStdout() : saved(std::cout.rdbuf(sink.rdbuf())) {}
+        ~SilenceStdout() { std::cout.rdbuf(saved); }
+    };
+
+    /**
+     * @brief Exchange-side view of a book, used to write the orderbook file a replay is validated against.
+     */
+    class ReferenceBook
+    {
+    private:
+        struct Resting
+        {
+            int direction; // 1 = bid, -1 = ask
+            Price price;   // Limit price in ticks
+            int size;      // Remaining size
+        };
+
+        std::unordered_map<int, Resting> orders; // LOBSTER id -> order
+        std::map<Price, int> bids;               // Price -> total size
+        std::map<Price, int> asks;               // Price -> total size
+
+        void change(int direction, Price price, int delta)
+        {
+            std::map<Price, int> &side = direction == 1 ? bids : asks;
+            if ((side[price] += delta) == 0)
+                side.erase(price);
+        }
+
+    public:
+        void rest(int order_id, int direction, Price price, int size)
+        {
+            orders[order_id] = Resting{direction, price, size};
+            change(direction, price, size);
+        }
+
+        void apply(const LobsterMessage &msg)
+        {
+            if (msg.type == LobsterMessageType::NEW_ORDER)
+            {
+                rest(msg.order_id, msg.direction, msg.price, msg.size);
+                return;
+            }
+            if (msg.type == LobsterMessageType::EXECUTION_HIDDEN || msg.type == LobsterMessageType::TRADING_HALT)
+                return;
+
+            Resting &order = orders.at(msg.order_id);
+            order.size -= msg.size;
+            change(order.direction, order.price, -msg.size);
+            if (order.size == 0)
+                orders.erase(msg.order_id);
+        }
+
+        void write_row(std::ostream &out, size_t levels) const
+        {
+            auto ask = asks.begin();
+            auto bid = bids.rbegin();
+            for (size_t i = 0; i < levels; i++)
+            {
+                out << (i ? "," : "");
+                if (ask != asks.end())
+                    out << ask->first << "," << ask++->second;
+                else
+                    out << "9999999999,0";
+                if (bid != bids.rend())
+                    out << "," << bid->first << "," << bid++->second;
+                else
+                    out << ",-9999999999,0";
+            }
+            out << "\n";
+        }
+    };
+
+    void write_message(std::ostream &out, const LobsterMessage &msg)
+    {
+        char line[128];
+        std::snprintf(line, sizeof(line), "%.9f,%d,%d,%d,%lld,%d\n", msg.timestamp, static_cast<int>(msg.type),
+                      msg.order_id, msg.size, static_cast<long long>(msg.price), msg.direction);
+        out << line;
+    }
+
+    // A file cut from the middle of a day: every level already holds orders the file never adds
+    void test_validate_mid_day_file()
+    {
+        const std::string messages_file = "lob_tests_messages.csv";
+        const std::string orderbook_file = "lob_tests_orderbook.csv";
+        const size_t levels = 3;
+
+        // Two orders per level on seven levels a side, ids 1000 (asks) and 2000 (bids) upwards
+        ReferenceBook exchange;
+        auto ask_id = [](int level, int order) { return 1000 + level * 2 + order; };
+        auto bid_id = [](int level, int order) { return 2000 + level * 2 + order; };
+        for (int level = 0; level < 7; level++)
+        {
+            exchange.rest(ask_id(level, 0), -1, 10100 + 100 * level, 100);
+            exchange.rest(ask_id(level, 1), -1, 10100 + 100 * level, 50);
+            exchange.rest(bid_id(level, 0), 1, 9900 - 100 * level, 100);
+            exchange.rest(bid_id(level, 1), 1, 9900 - 100 * level, 50);
+        }
+
+        using Type = LobsterMessageType;
+        std::vector<LobsterMessage> script = {
+            {1.0, Type::NEW_ORDER, 1, 30, 10200, -1},          // First message: an add at a seeded level
+            {2.0, Type::CANCELLATION, ask_id(0, 0), 20, 10100, -1},
+            {3.0, Type::CANCELLATION, ask_id(4, 0), 10, 10500, -1}, // Level 5 is not in view yet
+            {4.0, Type::EXECUTION_VISIBLE, bid_id(0, 1), 50, 9900, 1},
+            {5.0, Type::DELETION, ask_id(0, 0), 80, 10100, -1},
+            {6.0, Type::DELETION, ask_id(0, 1), 50, 10100, -1},     // 10400 comes into view
+            {7.0, Type::DELETION, ask_id(1, 0), 100, 10200, -1},
+            {8.0, Type::DELETION, ask_id(1, 1), 50, 10200, -1},
+            {9.0, Type::DELETION, 1, 30, 10200, -1},                // 10500 comes into view
+            {10.0, Type::EXECUTION_VISIBLE, ask_id(4, 0), 90, 10500, -1},
+            {11.0, Type::NEW_ORDER, 2, 10, 9950, 1},
+            {12.0, Type::EXECUTION_HIDDEN, 0, 5, 10000, 1},
+            {13.0, Type::CANCELLATION, bid_id(1, 0), 40, 9800, 1},
+        };
+
+        {
+            std::ofstream messages(messages_file);
+            std::ofstream orderbook(orderbook_file);
+            for (const LobsterMessage &msg : script)
+            {
+                exchange.apply(msg);
+                write_message(messages, msg);
+                exchange.write_row(orderbook, levels);
+            }
+        }
+
+        for (ReplayMode mode : {ReplayMode::MATCHING, ReplayMode::RECONSTRUCTION})
+        {
+            LobsterReplayEngine engine;
+            engine.set_mode(mode);
+            ValidationReport report;
+            {
+                SilenceStdout quiet;
+                CHECK(engine.load_data(messages_file));
+                report = engine.replay_validate(orderbook_file);
+            }
+
+            CHECK(report.levels == levels);
+            CHECK(report.compared == script.size() - 1);
+            CHECK(report.diverged == 0);
+            CHECK(report.revealed_levels == 2);
+            CHECK(report.seeded_updates == 8);
+            CHECK(report.unknown_ids == 1);
+        }
+
+        std::remove(messages_file.c_str());
+        std::remove(orderbook_file.c_str());
+    }
+
+    // Size of the best level on one side, 0 if the side is empty
+    template <typename Book>
+    int best_level_size(const Book &book, OrderSide side)
+    {
+        DepthLevel level;
+        book.get_depth(&level, 1);
+        return side == OrderSide::BUY ? level.bid_size : level.ask_size;
+    }
+
+    // A resting order as the tests compare it; timestamps depend on the clock and are left out
+    struct RestingOrder
+    {
+        int id;
+        OrderSide side;
+        Price price;
+        int quantity;
+
+        bool operator==(const RestingOrder &other) const
+        {
+            return id == other.id && side == other.side && price == other.price && quantity == other.quantity;
+        }
+    };
+
+    // Every resting order, bids then asks, best level first and in queue order within a level
+    template <typename Book>
+    std::vector<RestingOrder> resting_orders(const Book &book)
+    {
+        std::vector<RestingOrder> orders;
+        book.for_each_order([&orders](const Order &order)
+                            { orders.push_back(RestingOrder{order.id, order.side, order.price, order.quantity}); });
+        return orders;
+    }
+
+    // Applies one command through the book's public call, as process_batch promises to
+    template <typename Book>
+    int apply_command(Book &book, const BookCommand &command)
+    {
+        switch (command.type)
+        {
+        case BookCommandType::LIMIT:
+            return book.add_limit_order(command.side, command.price, command.quantity);
+        case BookCommandType::MARKET:
+            book.add_market_order(command.side, command.quantity);
+            return 0;
+        case BookCommandType::CANCEL:
+            return book.cancel_order(command.order_id) ? 1 : 0;
+        case BookCommandType::REDUCE:
+            return book.reduce_order(command.order_id, command.quantity);
+        case BookCommandType::INSERT:
+            return book.insert_order(command.side, command.price, command.quantity);
+        case BookCommandType::FILL:
+            return book.fill_order(command.order_id, command.quantity);
+        }
+        return -1;
+    }
+
+    /**
+     * @brief A book whose trades and coalesced level deltas the tests can read back.
+     */
+    template <typename Levels>
+    struct ObservedBook
+    {
+        BasicLimitOrderBook<Levels, MarketDataSink> book;
+        MarketDataFeed feed;
+        SpscRing<LevelDelta> deltas;
+
+        ObservedBook() : deltas(1 << 16)
+        {
+            feed.attach_ring(&deltas);
+            book.get_event_sink().attach_feed(&feed);
+        }
+
+        // Ends a span of commands; returns its trades and level deltas as comparable text
+        std::string take_events(uint64_t sequence)
+        {
+            std::ostringstream out;
+            TradeRecorder &recorder = book.get_event_sink();
+            for (const TradeEvent &trade : recorder.get_trades())
+            {
+                out << "T " << trade.aggressive_order_id << " " << trade.passive_order_id << " "
+                    << static_cast<int>(trade.aggressor_side) << " " << trade.price << " " << trade.quantity << "\n";
+            }
+            out << "dropped " << recorder.get_dropped() << "\n";
+            recorder.clear();
+
+            feed.publish(sequence, 0);
+            LevelDelta delta;
+            while (deltas.try_pop(delta))
+            {
+                out << "L " << delta.sequence << " " << static_cast<int>(delta.side) << " " << delta.price << " "
+                    << delta.quantity << " " << delta.order_count << "\n";
+            }
+            return out.str();
+        }
+    };
+
+    /**
+     * @brief Seeded random book commands around a mid price.
+     *
+     * Most limit prices sit on the cent grid near the mid; some are off the grid or far
+     * outside the ladder's window, so level stores are exercised beyond their fast path.
+     * Cancels, reduces and fills target ids the book has handed out, ids it has not, and
+     * often ids predicted for adds earlier in the same batch.
+     */
+    class CommandGenerator
+    {
+    private:
+        std::mt19937 rng;
+        Price mid;
+
+        Price random_price(OrderSide side)
+        {
+            const Price tick = LadderPriceLevels::DEFAULT_TICK_SIZE;
+            unsigned pick = static_cast<unsigned>(rng() % 100);
+            Price offset = tick * static_cast<Price>(rng() % 40) - 5 * tick; // A few cross the mid
+            if (pick < 5)
+                offset += 37;                                                 // Off the tick grid
+            else if (pick < 10)
+                offset = tick * static_cast<Price>(3000 + rng() % 6000);     // Outside the window
+            return side == OrderSide::BUY ? mid - offset : mid + offset;
+        }
+
+        int random_quantity(int max)
+        {
+            // Now and then a quantity the book must reject
+            unsigned pick = static_cast<unsigned>(rng() % 100);
+            if (pick < 2)
+                return 0;
+            if (pick < 4)
+                return -static_cast<int>(rng() % 50) - 1;
+            return 1 + static_cast<int>(rng() % max);
+        }
+
+    public:
+        explicit CommandGenerator(uint32_t seed, Price mid = 100 * PRICE_SCALE) : rng(seed), mid(mid) {}
+
+        unsigned next(unsigned bound) { return static_cast<unsigned>(rng() % bound); }
+
+        /**
+         * @brief Builds a batch for a book whose next order id is first_id.
+         */
+        std::vector<BookCommand> batch(size_t count, int first_id)
+        {
+            std::vector<BookCommand> commands;
+            int next_id = first_id;
+            int last_target = 0;
+            for (size_t i = 0; i < count; i++)
+            {
+                OrderSide side = rng() % 2 ? OrderSide::BUY : OrderSide::SELL;
+                unsigned pick = static_cast<unsigned>(rng() % 100);
+                BookCommand command{BookCommandType::LIMIT, side, 0, 0, 0};
+                if (pick < 35 || next_id == 1)
+                {
+                    command.price = random_price(side);
+                    command.quantity = 1 + static_cast<int>(rng() % 200);
+                }
+                else if (pick < 40)
+                {
+                    command.type = BookCommandType::MARKET;
+                    command.quantity = 1 + static_cast<int>(rng() % 300);
+                }
+                else if (pick < 50)
+                {
+                    command.type = BookCommandType::INSERT;
+                    command.price = random_price(side);
+                    command.quantity = 1 + static_cast<int>(rng() % 200);
+                }
+                else
+                {
+                    unsigned target = static_cast<unsigned>(rng() % 10);
+                    if (target < 2 && last_target > 0)
+                        command.order_id = last_target;                                // Again, right after
+                    else if (target < 6 && next_id > first_id)
+                        command.order_id = first_id + static_cast<int>(rng() % (next_id - first_id)); // Predicted
+                    else
+                        command.order_id = static_cast<int>(rng() % (next_id + 3));    // Any, some not issued
+                    last_target = command.order_id;
+
+                    command.type = pick < 65 ? BookCommandType::CANCEL
+                                   : pick < 85 ? BookCommandType::REDUCE
+                                               : BookCommandType::FILL;
+                    command.quantity = random_quantity(150);
+                }
+
+                if (command.type == BookCommandType::LIMIT || command.type == BookCommandType::MARKET ||
+                    command.type == BookCommandType::INSERT)
+                    next_id++;
+                commands.push_back(command);
+            }
+            return commands;
+        }
+    };
+
+    // A batch must leave results, events and the book exactly as the same commands one call at a time
+    template <typename Levels>
+    void check_batch_matches_single_calls(uint32_t seed)
+    {
+        ObservedBook<Levels> batched;
+        ObservedBook<Levels> single;
+        CommandGenerator generator(seed);
+
+        for (uint64_t round = 1; round <= 400; round++)
+        {
+            size_t count = 1 + generator.next(64);
+            std::vector<BookCommand> commands = generator.batch(count, batched.book.get_next_order_id());
+
+            std::vector<int> batch_results(count);
+            std::vector<int> single_results(count);
+            batched.book.process_batch(commands.data(), count, batch_results.data());
+            for (size_t i = 0; i < count; i++)
+                single_results[i] = apply_command(single.book, commands[i]);
+
+            bool same = batch_results == single_results;
+            same = same && batched.take_events(round) == single.take_events(round);
+            same = same && resting_orders(batched.book) == resting_orders(single.book);
+            same = same && batched.book.get_next_order_id() == single.book.get_next_order_id();
+            CHECK(same);
+            if (!same)
+            {
+                std::cerr << "  seed " << seed << ", round " << round << std::endl;
+                return;
+            }
+        }
+        CHECK(!resting_orders(batched.book).empty());
+    }
+
+    void test_batch_matches_single_calls()
+    {
+        for (uint32_t seed : {1u, 2u, 3u})
+        {
+            check_batch_matches_single_calls<MapPriceLevels>(seed);
+            check_batch_matches_single_calls<LadderPriceLevels>(seed);
+        }
+    }
+
+    // Seeded LOBSTER messages: adds, partial cancels, deletions and executions of live
+    // orders, often several in a row on one order, plus messages for unknown ids
+    std::vector<LobsterMessage> random_lobster_messages(uint32_t seed, size_t count)
+    {
+        struct Live
+        {
+            int id;
+            int direction;
+            Price price;
+            int size;
+        };
+
+        using Type = LobsterMessageType;
+        std::mt19937 rng(seed);
+        std::vector<Live> live;
+        std::vector<LobsterMessage> messages;
+        int next_id = 1;
+        int last_gone = 0;
+        size_t last = 0;
+        const Price mid = 100 * PRICE_SCALE;
+        const Price tick = LadderPriceLevels::DEFAULT_TICK_SIZE;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            double timestamp = 34200.0 + static_cast<double>(i) * 0.001;
+            unsigned pick = static_cast<unsigned>(rng() % 100);
+            if (live.empty() || pick < 40)
+            {
+                int direction = rng() % 2 ? 1 : -1;
+                Price offset = tick * static_cast<Price>(1 + rng() % 30);
+                if (pick < 2)
+                    offset = -tick; // Crosses the book, so matching mode trades
+                Live order{next_id++, direction, direction == 1 ? mid - offset : mid + offset,
+                           1 + static_cast<int>(rng() % 300)};
+                live.push_back(order);
+                messages.push_back({timestamp, Type::NEW_ORDER, order.id, order.size, order.price, direction});
+                continue;
+            }
+            if (pick < 44)
+            {
+                messages.push_back({timestamp, Type::CANCELLATION, 900000 + static_cast<int>(rng() % 100), 10,
+                                    mid, 1});
+                continue;
+            }
+            if (pick < 46)
+            {
+                messages.push_back({timestamp, Type::EXECUTION_HIDDEN, 0, 10, mid, -1});
+                continue;
+            }
+            if (pick < 48 && last_gone > 0)
+            {
+                messages.push_back({timestamp, Type::DELETION, last_gone, 10, mid, 1});
+                continue;
+            }
+
+            // Stay on the previous order half the time, so blocks see runs on one id
+            if (last >= live.size() || rng() % 2)
+                last = rng() % live.size();
+            Live &order = live[last];
+            unsigned action = static_cast<unsigned>(rng() % 3);
+            int size = action == 1 ? order.size : 1 + static_cast<int>(rng() % order.size);
+            Type type = action == 0 ? Type::CANCELLATION : action == 1 ? Type::DELETION : Type::EXECUTION_VISIBLE;
+            messages.push_back({timestamp, type, order.id, size, order.price, order.direction});
+            if ((order.size -= size) == 0)
+            {
+                last_gone = order.id;
+                live[last] = live.back();
+                live.pop_back();
+            }
+        }
+        return messages;
+    }
+
+    // An engine's statistics and depth as comparable text
+    std::string engine_outcome(const LobsterReplayEngine &engine)
+    {
+        std::ostringstream depth;
+        std::streambuf *saved_out = std::cout.rdbuf(depth.rdbuf());
+        engine.print_current_depth(100);
+        std::cout.rdbuf(saved_out);
+
+        ReplayStatistics stats = engine.get_statistics();
+        std::ostringstream out;
+        out << stats.processed_messages << " " << stats.successful_operations << " " << stats.failed_operations
+            << " " << stats.trades_executed << " " << stats.matched_trades << " " << stats.active_orders << "\n"
+            << depth.str();
+        return out.str();
+    }
+
+    // Replays a file with the given block size; returns the statistics, depth and warnings as text
+    std::string replay_outcome(const std::string &filename, ReplayMode mode, size_t batch_size)
+    {
+        LobsterReplayEngine engine;
+        engine.set_mode(mode);
+        engine.set_batch_size(batch_size);
+
+        std::ostringstream warnings;
+        std::streambuf *saved = std::cerr.rdbuf(warnings.rdbuf());
+        {
+            SilenceStdout quiet;
+            engine.load_data(filename);
+            engine.replay_silent();
+        }
+        std::cerr.rdbuf(saved);
+        return engine_outcome(engine) + warnings.str();
+    }
+
+    // Replay blocks predict the ids of their adds and split where an order may already be gone
+    void test_replay_blocks_match_message_replay()
+    {
+        const std::string filename = "lob_tests_blocks.csv";
+        {
+            std::ofstream file(filename);
+            for (const LobsterMessage &msg : random_lobster_messages(7, 20000))
+                write_message(file, msg);
+        }
+
+        for (ReplayMode mode : {ReplayMode::MATCHING, ReplayMode::RECONSTRUCTION})
+        {
+            std::string expected = replay_outcome(filename, mode, 1);
+            CHECK(expected.find("Warning") != std::string::npos);
+            for (size_t batch_size : {size_t(2), size_t(7), LobsterReplayEngine::RECOMMENDED_BATCH_SIZE})
+                CHECK(replay_outcome(filename, mode, batch_size) == expected);
+        }
+
+        std::remove(filename.c_str());
+    }
+
+    // Prices of every level in priority order
+    template <typename Levels>
+    std::vector<Price> level_prices(const Levels &levels)
+    {
+        std::vector<Price> prices;
+        levels.visit_levels(SIZE_MAX, [&prices](Price price, const OrderQueue &) { prices.push_back(price); });
+        return prices;
+    }
+
+    // The ladder must order, find and erase levels exactly like the map, in and out of its window
+    void check_ladder_matches_map_levels(OrderSide side, uint32_t seed)
+    {
+        MapPriceLevels map(side);
+        LadderPriceLevels ladder(side);
+        std::mt19937 rng(seed);
+        std::vector<Price> created;
+        const Price tick = LadderPriceLevels::DEFAULT_TICK_SIZE;
+
+        for (int cycle = 0; cycle < 60; cycle++)
+        {
+            // Each cycle builds around a centre far from the last one, then drains down,
+            // often to nothing, so the window empties and recentres on the overflow
+            Price centre = 100 * PRICE_SCALE + tick * static_cast<Price>(rng() % 20000) - 10000 * tick;
+            size_t adds = 1 + rng() % 200;
+            for (size_t i = 0; i < adds; i++)
+            {
+                Price price = centre + tick * (static_cast<Price>(rng() % 400) - 200);
+                if (rng() % 10 == 0)
+                    price += 37; // Off the grid
+                map.get_or_create(price);
+                ladder.get_or_create(price);
+                if (std::find(created.begin(), created.end(), price) == created.end())
+                    created.push_back(price);
+            }
+
+            size_t keep = rng() % 3 == 0 ? 0 : rng() % (created.size() + 1);
+            while (created.size() > keep)
+            {
+                size_t victim = rng() % created.size();
+                Price price = created[victim];
+                created[victim] = created.back();
+                created.pop_back();
+                map.erase(price);
+                ladder.erase(price);
+                CHECK((map.find(price) == nullptr) == (ladder.find(price) == nullptr));
+            }
+
+            bool same = map.size() == ladder.size() && map.empty() == ladder.empty() &&
+                        level_prices(map) == level_prices(ladder);
+            if (same && !map.empty())
+                same = map.best_price() == ladder.best_price();
+            for (Price price : created)
+                same = same && map.find(price) && ladder.find(price);
+            CHECK(same);
+            if (!same)
+                return;
+        }
+    }
+
+    void test_ladder_matches_map_levels()
+    {
+        for (uint32_t seed : {1u, 2u, 3u})
+        {
+            check_ladder_matches_map_levels(OrderSide::BUY, seed);
+            check_ladder_matches_map_levels(OrderSide::SELL, seed);
+        }
+    }
+
+    // Runs commands one call at a time on a map book and a ladder book; every step must agree
+    class LevelStoreComparison
+    {
+    private:
+        ObservedBook<MapPriceLevels> map;
+        ObservedBook<LadderPriceLevels> ladder;
+        uint64_t steps = 0;
+
+    public:
+        bool step(const BookCommand &command)
+        {
+            steps++;
+            bool same = apply_command(map.book, command) == apply_command(ladder.book, command);
+            same = same && map.take_events(steps) == ladder.take_events(steps);
+            same = same && resting_orders(map.book) == resting_orders(ladder.book);
+            CHECK(same);
+            return same;
+        }
+    };
+
+    void test_ladder_matches_map_book()
+    {
+        const Price tick = LadderPriceLevels::DEFAULT_TICK_SIZE;
+        const Price mid = 100 * PRICE_SCALE;
+        const Price far = 3000 * tick; // Outside the window around the first price
+        using Type = BookCommandType;
+
+        // Directed: levels outside the window and off the grid, then the window drains
+        // and recentres on the overflow while orders are resting there
+        std::vector<BookCommand> script = {
+            {Type::LIMIT, OrderSide::BUY, 0, 100, mid - tick},           // id 1
+            {Type::LIMIT, OrderSide::BUY, 0, 50, mid - 2 * tick},        // id 2
+            {Type::LIMIT, OrderSide::BUY, 0, 70, mid - far},             // id 3, overflow
+            {Type::LIMIT, OrderSide::BUY, 0, 20, mid - far - 37},        // id 4, off the grid
+            {Type::LIMIT, OrderSide::BUY, 0, 10, mid - tick - 37},       // id 5, off the grid between 1 and 2
+            {Type::CANCEL, OrderSide::BUY, 5, 0, 0},
+            {Type::CANCEL, OrderSide::BUY, 1, 0, 0},
+            {Type::CANCEL, OrderSide::BUY, 2, 0, 0},                     // Window empty: recentre on id 3
+            {Type::LIMIT, OrderSide::BUY, 0, 40, mid + tick},            // id 6, outside the new window
+            {Type::LIMIT, OrderSide::BUY, 0, 30, mid - far + tick},      // id 7
+            {Type::MARKET, OrderSide::SELL, 0, 120, 0},                  // Overflow, window, then off-grid
+            {Type::LIMIT, OrderSide::SELL, 0, 100, mid + 2 * tick},      // id 9
+            {Type::LIMIT, OrderSide::SELL, 0, 60, mid + far},            // id 10
+            {Type::CANCEL, OrderSide::SELL, 9, 0, 0},                    // Ask window recentres on id 10
+            {Type::LIMIT, OrderSide::SELL, 0, 25, mid + 3 * tick},       // id 11, below the new window
+            {Type::LIMIT, OrderSide::BUY, 0, 200, mid + far + tick},     // id 12 sweeps both asks
+            {Type::MARKET, OrderSide::SELL, 0, 500, 0},                  // Empties the bids
+        };
+        LevelStoreComparison directed;
+        for (const BookCommand &command : script)
+        {
+            if (!directed.step(command))
+                return;
+        }
+
+        // Random: the same generator the batch test uses, one call at a time
+        for (uint32_t seed : {4u, 5u})
+        {
+            LevelStoreComparison random;
+            CommandGenerator generator(seed);
+            int next_id = 1;
+            for (int round = 0; round < 200; round++)
+            {
+                for (const BookCommand &command : generator.batch(1 + generator.next(32), next_id))
+                {
+                    if (!random.step(command))
+                        return;
+                    if (command.type == Type::LIMIT || command.type == Type::MARKET || command.type == Type::INSERT)
+                        next_id++;
+                }
+            }
+        }
+    }
+
+    // Ids front to back; every link must agree with its neighbour's link back
+    std::vector<int> queue_ids(const OrderQueue &queue)
+    {
+        std::vector<int> ids;
+        const Order *previous = nullptr;
+        for (const Order *order = queue.front(); order; order = order->next)
+        {
+            if (order->prev != previous)
+                return {-1};
+            ids.push_back(order->id);
+            previous = order;
+        }
+        return ids;
+    }
+
+    void test_queue_unlinks_any_order()
+    {
+        std::vector<Order> orders;
+        for (int id = 1; id <= 5; id++)
+            orders.emplace_back(id, OrderSide::SELL, OrderType::LIMIT, 10100, 10 * id, id);
+
+        OrderQueue queue;
+        for (Order &order : orders)
+            queue.add_order(&order);
+        CHECK(queue_ids(queue) == std::vector<int>({1, 2, 3, 4, 5}));
+        CHECK(queue.size() == 5 && queue.get_total_quantity() == 150);
+
+        // Middle, head, then tail; each unlinked order is left detached
+        CHECK(queue.remove_order(&orders[2]));
+        CHECK(queue_ids(queue) == std::vector<int>({1, 2, 4, 5}));
+        CHECK(orders[2].prev == nullptr && orders[2].next == nullptr);
+        CHECK(queue.remove_order(&orders[0]));
+        CHECK(queue_ids(queue) == std::vector<int>({2, 4, 5}));
+        CHECK(queue.front() == &orders[1]);
+        CHECK(queue.remove_order(&orders[4]));
+        CHECK(queue_ids(queue) == std::vector<int>({2, 4}));
+        CHECK(queue.size() == 2 && queue.get_total_quantity() == 60);
+        CHECK(!queue.remove_order(nullptr));
+
+        // New orders go behind the new tail
+        queue.add_order(&orders[2]);
+        CHECK(queue_ids(queue) == std::vector<int>({2, 4, 3}));
+
+        // Reducing keeps the order in place; out-of-range quantities change nothing
+        CHECK(queue.reduce_order(&orders[3], 15));
+        CHECK(!queue.reduce_order(&orders[3], 0));
+        CHECK(!queue.reduce_order(&orders[3], 25));
+        CHECK(orders[3].quantity == 25 && queue.get_total_quantity() == 75);
+        CHECK(queue_ids(queue) == std::vector<int>({2, 4, 3}));
+
+        queue.update_quantity(5);
+        CHECK(orders[1].quantity == 5 && queue.get_total_quantity() == 60);
+        queue.pop();
+        CHECK(queue_ids(queue) == std::vector<int>({4, 3}));
+        queue.remove_order(&orders[2]);
+        queue.remove_order(&orders[3]);
+        CHECK(queue.empty() && queue.front() == nullptr);
+        CHECK(queue.size() == 0 && queue.get_total_quantity() == 0);
+    }
+
+    void test_cancel_keeps_time_priority()
+    {
+        LimitOrderBook book;
+        int first = book.add_limit_order(OrderSide::SELL, 10100, 10);
+        int middle = book.add_limit_order(OrderSide::SELL, 10100, 20);
+        int last = book.add_limit_order(OrderSide::SELL, 10100, 30);
+        int after = book.add_limit_order(OrderSide::SELL, 10100, 40);
+
+        CHECK(book.cancel_order(middle));
+        CHECK(!book.cancel_order(middle));
+        CHECK(best_level_size(book, OrderSide::SELL) == 80);
+
+        // The buy fills the survivors in arrival order
+        book.add_market_order(OrderSide::BUY, 35);
+        std::vector<RestingOrder> expected = {{last, OrderSide::SELL, 10100, 5},
+                                              {after, OrderSide::SELL, 10100, 40}};
+        CHECK(resting_orders(book) == expected);
+        CHECK(!book.cancel_order(first));
+
+        CHECK(book.cancel_order(after));
+        CHECK(book.cancel_order(last));
+        CHECK(resting_orders(book).empty());
+        int next = book.add_limit_order(OrderSide::SELL, 10100, 50);
+        CHECK(resting_orders(book) == std::vector<RestingOrder>({{next, OrderSide::SELL, 10100, 50}}));
+    }
+
+    // Every key the reference holds must map to the same value, and nothing else may be present
+    bool index_matches(const OrderIdIndex<long long> &index, const std::unordered_map<int, long long> &reference,
+                       const std::vector<int> &keys)
+    {
+        if (index.size() != reference.size())
+            return false;
+        for (int key : keys)
+        {
+            const long long *value = index.find(key);
+            auto it = reference.find(key);
+            if ((value == nullptr) != (it == reference.end()) || (value && *value != it->second))
+                return false;
+        }
+
+        size_t visited = 0;
+        bool same = true;
+        index.for_each([&](int key, long long value)
+                       {
+                           auto it = reference.find(key);
+                           same = same && it != reference.end() && it->second == value;
+                           visited++;
+                       });
+        return same && visited == reference.size();
+    }
+
+    // Random inserts, overwrites and erases over a small key pool keep the table loaded,
+    // so erases land inside probe clusters and must shift their tails back correctly
+    void check_id_index_matches_map(IdIndexMode mode, const std::vector<int> &keys, uint32_t seed)
+    {
+        OrderIdIndex<long long> index(mode);
+        std::unordered_map<int, long long> reference;
+        std::mt19937 rng(seed);
+
+        for (int step = 0; step < 20000; step++)
+        {
+            int key = keys[rng() % keys.size()];
+            if (rng() % 5 < 3)
+            {
+                long long value = static_cast<long long>(rng());
+                index.insert(key, value);
+                reference[key] = value;
+            }
+            else
+                CHECK(index.erase(key) == (reference.erase(key) == 1));
+
+            // A broken shift leaves other keys unreachable, so wide pools can be checked less often
+            if ((keys.size() <= 64 || step % 64 == 0) && !index_matches(index, reference, keys))
+            {
+                CHECK(index_matches(index, reference, keys));
+                return;
+            }
+        }
+
+        index.clear();
+        reference.clear();
+        CHECK(index_matches(index, reference, keys));
+    }
+
+    void test_id_index_matches_map()
+    {
+        // Sequential ids like the book issues, plus keys far apart and of either sign
+        std::vector<int> keys;
+        for (int key = 1; key <= 48; key++)
+            keys.push_back(key);
+        for (int key : {0, -1, -7, 1 << 20, (1 << 20) + 1, INT_MAX, INT_MIN, INT_MIN + 1})
+            keys.push_back(key);
+        check_id_index_matches_map(IdIndexMode::HASHED, keys, 1);
+        check_id_index_matches_map(IdIndexMode::HASHED, keys, 5);
+
+        std::vector<int> wide;
+        std::mt19937 rng(2);
+        for (int i = 0; i < 3000; i++)
+            wide.push_back(static_cast<int>(rng()));
+        check_id_index_matches_map(IdIndexMode::HASHED, wide, 3);
+
+        // DENSE grows to fit whatever non-negative id arrives
+        std::vector<int> dense_keys;
+        for (int key = 0; key < 600; key += 3)
+            dense_keys.push_back(key);
+        check_id_index_matches_map(IdIndexMode::DENSE, dense_keys, 4);
+    }
+
+    void test_dense_index_ignores_out_of_range_ids()
+    {
+        OrderIdIndex<long long> index;
+        index.configure(IdIndexMode::DENSE, 8);
+        CHECK(index.get_mode() == IdIndexMode::DENSE);
+
+        index.insert(3, 30);
+        index.insert(5000, 50000);
+        CHECK(index.size() == 2);
+        CHECK(index.find(3) && *index.find(3) == 30);
+        CHECK(index.find(5000) && *index.find(5000) == 50000);
+        CHECK(index.find(4999) == nullptr);
+        CHECK(index.find(-3) == nullptr);
+        CHECK(index.find(INT_MAX) == nullptr);
+        CHECK(!index.erase(-3));
+        CHECK(!index.erase(INT_MAX));
+        CHECK(!index.erase(4));
+        CHECK(index.size() == 2);
+
+        std::vector<int> visited;
+        index.for_each([&visited](int key, long long) { visited.push_back(key); });
+        CHECK(visited == std::vector<int>({3, 5000}));
+
+        CHECK(index.erase(3));
+        CHECK(!index.erase(3));
+        CHECK(index.find(3) == nullptr && index.size() == 1);
+
+        // Switching modes starts empty
+        index.configure(IdIndexMode::HASHED, 8);
+        CHECK(index.size() == 0 && index.find(5000) == nullptr);
+        index.insert(-3, 7);
+        CHECK(index.find(-3) && *index.find(-3) == 7);
+    }
+
+    void test_reduce_rejects_non_positive_quantity()
+    {
+        LimitOrderBook book;
+        int id = book.add_limit_order(OrderSide::BUY, 9900, 100);
+
+        CHECK(book.reduce_order(id, 0) == -1);
+        CHECK(book.reduce_order(id, -50) == -1);
+        CHECK(best_level_size(book, OrderSide::BUY) == 100);
+
+        BookCommand commands[] = {{BookCommandType::REDUCE, OrderSide::BUY, id, 0, 0},
+                                  {BookCommandType::REDUCE, OrderSide::BUY, id, -50, 0},
+                                  {BookCommandType::REDUCE, OrderSide::BUY, id, 30, 0}};
+        int results[3];
+        book.process_batch(commands, 3, results);
+        CHECK(results[0] == -1);
+        CHECK(results[1] == -1);
+        CHECK(results[2] == 70);
+        CHECK(best_level_size(book, OrderSide::BUY) == 70);
+    }
+
+    void test_fill_rejects_non_positive_quantity()
+    {
+        LimitOrderBook book;
+        int id = book.insert_order(OrderSide::SELL, 10100, 100);
+
+        CHECK(book.fill_order(id, 0) == -1);
+        CHECK(book.fill_order(id, -40) == -1);
+        CHECK(best_level_size(book, OrderSide::SELL) == 100);
+
+        BookCommand commands[] = {{BookCommandType::FILL, OrderSide::SELL, id, -40, 0},
+                                  {BookCommandType::FILL, OrderSide::SELL, id, 60, 0},
+                                  {BookCommandType::FILL, OrderSide::SELL, id, 40, 0}};
+        int results[3];
+        book.process_batch(commands, 3, results);
+        CHECK(results[0] == -1);
+        CHECK(results[1] == 40);
+        CHECK(results[2] == 0);
+        CHECK(best_level_size(book, OrderSide::SELL) == 0);
+    }
+
+    // Overwrites a field of a snapshot held in a string
+    template <typename T>
+    std::string patched(std::string snapshot, size_t offset, T value)
+    {
+        return snapshot.replace(offset, sizeof(value), reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    // Loading the snapshot into a fresh DENSE-indexed book must fail and leave it empty
+    void check_book_snapshot_rejected(const std::string &snapshot)
+    {
+        LimitOrderBook book;
+        book.configure_order_index(IdIndexMode::DENSE, 16);
+        std::istringstream in(snapshot);
+        CHECK(!book.load_state(in));
+        CHECK(book.get_order_pool().size() == 0);
+        CHECK(book.get_next_order_id() == 1);
+    }
+
+    void test_snapshot_rejects_invalid_records()
+    {
+        LimitOrderBook original;
+        original.add_limit_order(OrderSide::BUY, 9900, 100);
+        original.add_limit_order(OrderSide::BUY, 9800, 50);
+        original.add_limit_order(OrderSide::SELL, 10100, 70);
+        std::ostringstream out;
+        CHECK(original.save_state(out));
+        const std::string snapshot = out.str();
+
+        {
+            LimitOrderBook book;
+            book.configure_order_index(IdIndexMode::DENSE, 16);
+            std::istringstream in(snapshot);
+            CHECK(book.load_state(in));
+            CHECK(resting_orders(book) == resting_orders(original));
+        }
+
+        const size_t first = sizeof(BookSnapshotHeader);
+        const size_t second = first + sizeof(BookSnapshotRecord);
+        check_book_snapshot_rejected(patched(snapshot, first + offsetof(BookSnapshotRecord, id), int32_t(-5)));
+        check_book_snapshot_rejected(patched(snapshot, first + offsetof(BookSnapshotRecord, id), int32_t(4)));
+        check_book_snapshot_rejected(patched(snapshot, second + offsetof(BookSnapshotRecord, id), int32_t(1)));
+        check_book_snapshot_rejected(patched(snapshot, first + offsetof(BookSnapshotRecord, quantity), int32_t(0)));
+        check_book_snapshot_rejected(patched(snapshot, first + offsetof(BookSnapshotRecord, quantity), int32_t(-10)));
+        check_book_snapshot_rejected(patched(snapshot, first + offsetof(BookSnapshotRecord, side), int8_t(3)));
+        check_book_snapshot_rejected(patched(snapshot, offsetof(BookSnapshotHeader, next_order_id), int64_t(1) << 40));
+        std::string large_counter = patched(snapshot, offsetof(BookSnapshotHeader, next_order_id), int64_t(INT_MAX));
+        check_book_snapshot_rejected(
+            patched(large_counter, offsetof(BookSnapshotHeader, order_count), uint64_t(1) << 30));
+        check_book_snapshot_rejected(snapshot.substr(0, snapshot.size() - 1));
+
+        // The replay id map is bounded by the stream and must point at ids the book handed out
+        const std::string messages_file = "lob_tests_snapshot.csv";
+        {
+            std::ofstream file(messages_file);
+            for (const LobsterMessage &msg : random_lobster_messages(11, 200))
+                write_message(file, msg);
+        }
+
+        LobsterReplayEngine engine;
+        std::ostringstream replay_out;
+        std::ostringstream errors;
+        std::streambuf *saved = std::cerr.rdbuf(errors.rdbuf());
+        {
+            SilenceStdout quiet;
+            CHECK(engine.load_data(messages_file));
+            engine.replay_n_messages(100);
+            CHECK(engine.save_state(replay_out));
+        }
+        const std::string replay = replay_out.str();
+
+        BookSnapshotHeader book_header;
+        std::memcpy(&book_header, replay.data() + sizeof(ReplaySnapshotHeader), sizeof(book_header));
+        const size_t pairs = sizeof(ReplaySnapshotHeader) + sizeof(BookSnapshotHeader) +
+                             book_header.order_count * sizeof(BookSnapshotRecord);
+        CHECK(pairs < replay.size());
+
+        for (const std::string &corrupt :
+             {patched(replay, offsetof(ReplaySnapshotHeader, id_count), uint64_t(1) << 60),
+              patched(replay, pairs + offsetof(ReplaySnapshotIdPair, internal_id), int32_t(0)),
+              patched(replay, pairs + offsetof(ReplaySnapshotIdPair, internal_id), int32_t(1) << 30)})
+        {
+            std::istringstream in(corrupt);
+            SilenceStdout quiet;
+            CHECK(!engine.load_state(in));
+            CHECK(engine.get_statistics().active_orders == 0);
+        }
+        {
+            std::istringstream in(replay);
+            SilenceStdout quiet;
+            CHECK(engine.load_state(in));
+            CHECK(engine.get_statistics().processed_messages == 100);
+        }
+        std::cerr.rdbuf(saved);
+        CHECK(errors.str().find("id map is corrupt") != std::string::npos);
+
+        std::remove(messages_file.c_str());
+    }
+
+    // Arrival timestamps of every resting order, in the order resting_orders lists them
+    template <typename Book>
+    std::vector<long long> order_timestamps(const Book &book)
+    {
+        std::vector<long long> timestamps;
+        book.for_each_order([&timestamps](const Order &order) { timestamps.push_back(order.timestamp); });
+        return timestamps;
+    }
+
+    // A book loaded from a snapshot must hold the same orders and then behave exactly like the original
+    template <typename Levels>
+    void check_book_snapshot_round_trip(uint32_t seed)
+    {
+        ObservedBook<Levels> original;
+        CommandGenerator generator(seed);
+        std::vector<int> results(64);
+        for (int round = 0; round < 100; round++)
+        {
+            std::vector<BookCommand> commands = generator.batch(1 + generator.next(64),
+                                                                original.book.get_next_order_id());
+            original.book.process_batch(commands.data(), commands.size(), results.data());
+        }
+        original.take_events(1);
+        CHECK(!resting_orders(original.book).empty());
+
+        std::ostringstream out;
+        CHECK(original.book.save_state(out));
+        const std::string snapshot = out.str();
+
+        ObservedBook<Levels> restored;
+        std::istringstream in(snapshot);
+        CHECK(restored.book.load_state(in));
+        restored.take_events(1);
+        CHECK(resting_orders(restored.book) == resting_orders(original.book));
+        CHECK(order_timestamps(restored.book) == order_timestamps(original.book));
+        CHECK(restored.book.get_next_order_id() == original.book.get_next_order_id());
+        CHECK(restored.book.get_order_pool().size() == original.book.get_order_pool().size());
+
+        // Snapshots do not depend on the level store that wrote them
+        MapLimitOrderBook map_book;
+        LadderLimitOrderBook ladder_book;
+        std::istringstream map_in(snapshot);
+        std::istringstream ladder_in(snapshot);
+        CHECK(map_book.load_state(map_in) && ladder_book.load_state(ladder_in));
+        CHECK(resting_orders(map_book) == resting_orders(original.book));
+        CHECK(resting_orders(ladder_book) == resting_orders(original.book));
+
+        for (int round = 0; round < 50; round++)
+        {
+            std::vector<BookCommand> commands = generator.batch(1 + generator.next(64),
+                                                                original.book.get_next_order_id());
+            std::vector<int> restored_results(commands.size());
+            original.book.process_batch(commands.data(), commands.size(), results.data());
+            restored.book.process_batch(commands.data(), commands.size(), restored_results.data());
+
+            bool same = std::equal(restored_results.begin(), restored_results.end(), results.begin());
+            same = same && original.take_events(round + 2) == restored.take_events(round + 2);
+            same = same && resting_orders(original.book) == resting_orders(restored.book);
+            CHECK(same);
+            if (!same)
+                return;
+        }
+    }
+
+    void test_book_snapshot_round_trip()
+    {
+        for (uint32_t seed : {1u, 2u})
+        {
+            check_book_snapshot_round_trip<MapPriceLevels>(seed);
+            check_book_snapshot_round_trip<LadderPriceLevels>(seed);
+        }
+    }
+
+    // Saving mid-replay and resuming in a fresh engine must end where one uninterrupted replay ends
+    void test_replay_snapshot_round_trip()
+    {
+        const std::string filename = "lob_tests_resume.csv";
+        {
+            std::ofstream file(filename);
+            for (const LobsterMessage &msg : random_lobster_messages(17, 6000))
+                write_message(file, msg);
+        }
+
+        std::ostringstream warnings;
+        std::streambuf *saved = std::cerr.rdbuf(warnings.rdbuf());
+        for (ReplayMode mode : {ReplayMode::MATCHING, ReplayMode::RECONSTRUCTION})
+        {
+            std::string expected;
+            std::string snapshot;
+            {
+                SilenceStdout quiet;
+                LobsterReplayEngine full;
+                full.set_mode(mode);
+                CHECK(full.load_data(filename));
+                full.replay_silent();
+                expected = engine_outcome(full);
+
+                LobsterReplayEngine first;
+                first.set_mode(mode);
+                CHECK(first.load_data(filename));
+                first.replay_n_messages(2500);
+                std::ostringstream out;
+                CHECK(first.save_state(out));
+                snapshot = out.str();
+            }
+
+            for (bool streaming : {false, true})
+            {
+                SilenceStdout quiet;
+                LobsterReplayEngine resumed;
+                resumed.set_mode(mode);
+                std::istringstream in(snapshot);
+                CHECK(resumed.load_data(filename, streaming));
+                CHECK(resumed.load_state(in));
+                CHECK(resumed.get_statistics().processed_messages == 2500);
+                resumed.replay_silent();
+                CHECK(engine_outcome(resumed) == expected);
+            }
+        }
+        std::cerr.rdbuf(saved);
+
+        std::remove(filename.c_str());
+    }
+
+    // Seeking anywhere, in any direction, must leave the engine where replaying from the start leaves it
+    void test_seek_matches_full_replay()
+    {
+        const std::string filename = "lob_tests_seek.csv";
+        const size_t total = 20000;
+        {
+            std::ofstream file(filename);
+            for (const LobsterMessage &msg : random_lobster_messages(19, total))
+                write_message(file, msg);
+        }
+
+        // Message i is stamped 34200 + i ms; aim between stamps so a target covers exactly count messages
+        auto target = [](size_t count) { return 34200.0 + (static_cast<double>(count) - 0.5) * 0.001; };
+        const std::vector<size_t> counts = {12345, 3000, 2999, 7777, 0, 20000, 501, 18000};
+
+        std::ostringstream warnings;
+        std::streambuf *saved = std::cerr.rdbuf(warnings.rdbuf());
+        SilenceStdout quiet;
+        for (ReplayMode mode : {ReplayMode::MATCHING, ReplayMode::RECONSTRUCTION})
+        {
+            std::vector<std::string> expected;
+            for (size_t count : counts)
+            {
+                LobsterReplayEngine reference;
+                reference.set_mode(mode);
+                CHECK(reference.load_data(filename));
+                reference.replay_n_messages(static_cast<int>(count));
+                expected.push_back(engine_outcome(reference));
+            }
+            std::string expected_end;
+            {
+                LobsterReplayEngine reference;
+                reference.set_mode(mode);
+                CHECK(reference.load_data(filename));
+                reference.replay_silent();
+                expected_end = engine_outcome(reference);
+            }
+
+            for (bool streaming : {false, true})
+            {
+                LobsterReplayEngine engine;
+                engine.set_mode(mode);
+                engine.set_checkpoint_interval(1000);
+                CHECK(engine.load_data(filename, streaming));
+
+                // Forward from the start, back onto and just before a checkpoint, forward past
+                // a closer checkpoint, before the first message, to the end and back again
+                for (size_t i = 0; i < counts.size(); i++)
+                {
+                    CHECK(engine.seek(target(counts[i])));
+                    CHECK(engine.get_statistics().processed_messages == static_cast<int>(counts[i]));
+                    CHECK(engine_outcome(engine) == expected[i]);
+                }
+                CHECK(engine.get_checkpoint_count() >= total / 1000);
+
+                engine.replay_silent();
+                CHECK(engine_outcome(engine) == expected_end);
+            }
+        }
+        std::cerr.rdbuf(saved);
+
+        std::remove(filename.c_str());
+    }
+
+    // Replays count messages of a file and returns the engine's snapshot
+    std::string replay_snapshot(const std::string &filename, int count)
+    {
+        LobsterReplayEngine engine;
+        std::ostringstream out;
+        SilenceStdout quiet;
+        CHECK(engine.load_data(filename));
+        engine.replay_n_messages(count);
+        CHECK(engine.save_state(out));
+        return out.str();
+    }
+
+    // Restores a snapshot after loading a file in the given form; returns whether it was accepted
+    bool restores_against(const std::string &snapshot, const std::string &filename, bool streaming)
+    {
+        LobsterReplayEngine engine;
+        std::istringstream in(snapshot);
+        SilenceStdout quiet;
+        return engine.load_data(filename, streaming) && engine.load_state(in);
+    }
+
+    // A snapshot restores against any form of its own file, and not against another file of the same size
+    void test_snapshot_matches_its_message_file()
+    {
+        const std::string filename = "lob_tests_source.csv";
+        const std::string other = "lob_tests_other.csv";
+        const std::string cache = lobster_cache_path(filename);
+
+        std::vector<LobsterMessage> messages = random_lobster_messages(13, 300);
+        {
+            std::ofstream file(filename);
+            for (const LobsterMessage &msg : messages)
+                write_message(file, msg);
+        }
+        {
+            // Same lines in a different order: same size, and the same write time below
+            std::swap(messages[10], messages[11]);
+            std::ofstream file(other);
+            for (const LobsterMessage &msg : messages)
+                write_message(file, msg);
+        }
+        std::filesystem::last_write_time(other, std::filesystem::last_write_time(filename));
+        CHECK(std::filesystem::file_size(other) == std::filesystem::file_size(filename));
+
+        {
+            LobsterParser parser;
+            SilenceStdout quiet;
+            CHECK(parser.load_file(filename, false));
+            CHECK(parser.write_cache(cache));
+        }
+
+        std::ostringstream errors;
+        std::streambuf *saved = std::cerr.rdbuf(errors.rdbuf());
+        std::string snapshot = replay_snapshot(filename, 150);
+        CHECK(restores_against(snapshot, filename, false));
+        CHECK(restores_against(snapshot, filename, true));
+        CHECK(restores_against(snapshot, cache, false));
+        CHECK(!restores_against(snapshot, other, false));
+        CHECK(!restores_against(snapshot, other, true));
+        std::cerr.rdbuf(saved);
+        CHECK(errors.str().find("different message file") != std::string::npos);
+
+        // Streams hash the file in chunks; the stamp must equal the one taken from the mapping
+        const std::string large = "lob_tests_large.csv";
+        {
+            std::ofstream file(large);
+            for (size_t i = 0; file.tellp() < std::streamoff(3 << 19); i++)
+                write_message(file, messages[i % messages.size()]);
+            if (file.tellp() % 8 == 0)
+                file << "x";
+        }
+        MappedFile mapped;
+        CHECK(mapped.open(large));
+        CHECK(mapped.size() > (size_t(1) << 20) && mapped.size() % 8 != 0);
+        CHECK(same_lobster_source(stamp_lobster_file(large), stamp_lobster_source(large, mapped.data(), mapped.size())));
+        mapped.close();
+
+        for (const std::string &name : {filename, other, cache, large})
+            std::remove(name.c_str());
+    }
+
+    void test_parser_rejects_non_positive_size()
+    {
+        const std::string filename = "lob_tests_sizes.csv";
+        {
+            std::ofstream file(filename);
+            file << "34200.000000001,1,1,100,10000,1\n"
+                 << "34200.000000002,2,1,0,10000,1\n"   // Rejected: zero size
+                 << "34200.000000003,2,1,-20,10000,1\n" // Rejected: negative size
+                 << "34200.000000004,2,1,20,10000,1\n"
+                 << "34200.000000005,7,0,0,-1,-1\n";    // Halts carry no size
+        }
+
+        LobsterParser parser;
+        std::ostringstream errors;
+        std::streambuf *saved = std::cerr.rdbuf(errors.rdbuf());
+        {
+            SilenceStdout quiet;
+            CHECK(parser.load_file(filename, false));
+        }
+        std::cerr.rdbuf(saved);
+
+        CHECK(parser.get_total_messages() == 3);
+        CHECK(errors.str().find("Invalid size") != std::string::npos);
+
+        while (parser.has_next_message())
+        {
+            LobsterMessage msg = parser.get_next_message();
+            CHECK(msg.size > 0 || msg.type == LobsterMessageType::TRADING_HALT);
+        }
+
+        std::remove(filename.c_str());
+    }
+
+    // Several producers at once: every queued command is answered exactly once, in order per client
+    void test_gateway_acknowledges_each_command_once()
+    {
+        const int clients = 4;
+        const uint64_t commands_per_client = 5000;
+
+        // A small ingress queue and small rings so producers and the matcher both hit back-pressure
+        OrderGateway gateway(256);
+        for (int c = 0; c < clients; c++)
+            gateway.add_client(64);
+        gateway.start();
+
+        std::vector<std::vector<int>> acknowledged(clients, std::vector<int>(commands_per_client, 0));
+        std::vector<int> out_of_order(clients, 0);
+        std::vector<std::thread> producers;
+        for (int c = 0; c < clients; c++)
+        {
+            producers.emplace_back([&gateway, &acknowledged, &out_of_order, c, commands_per_client]()
+            {
+                uint64_t sent = 0, received = 0;
+                while (received < commands_per_client)
+                {
+                    if (sent < commands_per_client)
+                    {
+                        OrderSide side = (sent + c) % 2 ? OrderSide::BUY : OrderSide::SELL;
+                        Price price = side == OrderSide::BUY ? 9900 - static_cast<Price>(sent % 50)
+                                                             : 10100 + static_cast<Price>(sent % 50);
+                        BookCommand command{sent % 7 == 0 ? BookCommandType::MARKET : BookCommandType::LIMIT,
+                                            side, 0, 10, price};
+                        if (gateway.try_submit(c, sent, command) == SubmitResult::QUEUED)
+                            sent++;
+                    }
+
+                    GatewayResponse response;
+                    while (gateway.try_receive(c, response))
+                    {
+                        if (response.tag != received)
+                            out_of_order[c]++;
+                        if (response.tag < commands_per_client)
+                            acknowledged[c][response.tag]++;
+                        received++;
+                    }
+                }
+            });
+        }
+        for (std::thread &producer : producers)
+            producer.join();
+        gateway.stop();
+
+        for (int c = 0; c < clients; c++)
+        {
+            GatewayResponse extra;
+            CHECK(!gateway.try_receive(c, extra));
+            CHECK(out_of_order[c] == 0);
+            size_t once = 0;
+            for (int count : acknowledged[c])
+                once += count == 1;
+            CHECK(once == commands_per_client);
+        }
+        CHECK(gateway.get_dropped_responses() == 0);
+    }
+
+    void test_gateway_rejects_invalid_submissions()
+    {
+        OrderGateway gateway;
+        int client = gateway.add_client();
+        gateway.start();
+
+        BookCommand valid{BookCommandType::LIMIT, OrderSide::BUY, 0, 100, 9900};
+        CHECK(gateway.try_submit(-1, 0, valid) == SubmitResult::REJECTED);
+        CHECK(gateway.try_submit(client + 1, 0, valid) == SubmitResult::REJECTED);
+
+        BookCommand invalid[] = {
+            {BookCommandType::LIMIT, OrderSide::BUY, 0, 0, 9900},               // Zero quantity
+            {BookCommandType::LIMIT, OrderSide::SELL, 0, -10, 10100},           // Negative quantity
+            {BookCommandType::LIMIT, OrderSide::BUY, 0, 100, 0},                // No price
+            {BookCommandType::LIMIT, static_cast<OrderSide>(7), 0, 100, 9900},  // Unknown side
+            {BookCommandType::MARKET, OrderSide::SELL, 0, 0, 0},                // Zero quantity
+            {BookCommandType::CANCEL, OrderSide::BUY, 0, 0, 0},                 // No order id
+            {BookCommandType::REDUCE, OrderSide::BUY, 1, 0, 0},                 // Zero quantity
+            {BookCommandType::INSERT, OrderSide::BUY, 0, 100, 9900},            // Not a client operation
+            {BookCommandType::FILL, OrderSide::BUY, 1, 10, 0},                  // Not a client operation
+            {static_cast<BookCommandType>(42), OrderSide::BUY, 0, 100, 9900},   // Unknown type
+        };
+        for (const BookCommand &command : invalid)
+            CHECK(gateway.try_submit(client, 0, command) == SubmitResult::REJECTED);
+
+        CHECK(gateway.try_submit(client, 1, valid) == SubmitResult::QUEUED);
+        gateway.stop();
+
+        GatewayResponse response;
+        CHECK(!gateway.try_receive(-1, response));
+        CHECK(!gateway.try_receive(client + 1, response));
+        CHECK(gateway.try_receive(client, response));
+        CHECK(response.tag == 1 && response.result > 0);
+        CHECK(!gateway.try_receive(client, response));
+        CHECK(gateway.get_book().get_order_pool().size() == 1);
+    }
+
+    // A client that never reads must not keep stop() from returning
+    void test_gateway_stops_with_undrained_client()
+    {
+        OrderGateway gateway;
+        int client = gateway.add_client(2);
+        gateway.start();
+
+        // Once responses back up the client gets FULL; whatever was queued is still applied
+        int submitted = 0;
+        for (int i = 0; i < 10; i++)
+        {
+            SubmitResult result =
+                gateway.try_submit(client, submitted, BookCommand{BookCommandType::LIMIT, OrderSide::BUY, 0, 10, 9900});
+            CHECK(result != SubmitResult::REJECTED);
+            submitted += result == SubmitResult::QUEUED;
+        }
+        gateway.stop();
+
+        int received = 0;
+        GatewayResponse response;
+        while (gateway.try_receive(client, response))
+            CHECK(response.tag == static_cast<uint64_t>(received++));
+        CHECK(submitted > 2 && received == 2);
+        CHECK(gateway.get_dropped_responses() == static_cast<uint64_t>(submitted - 2));
+        CHECK(gateway.get_book().get_order_pool().size() == static_cast<size_t>(submitted));
+    }
+
+    // A client that stops reading gets FULL; the others keep getting their acknowledgements
+    void test_gateway_serves_others_past_undrained_client()
+    {
+        using Clock = std::chrono::steady_clock;
+        OrderGateway gateway(256);
+        int stuck = gateway.add_client(4);
+        const int others = 2;
+        for (int c = 0; c < others; c++)
+            gateway.add_client(64);
+        gateway.start();
+
+        // Fill the stuck client's ring and then some, until its responses back up
+        const BookCommand order{BookCommandType::LIMIT, OrderSide::BUY, 0, 10, 9900};
+        const Clock::time_point deadline = Clock::now() + std::chrono::seconds(20);
+        uint64_t stuck_sent = 0;
+        while (Clock::now() < deadline)
+        {
+            SubmitResult result = gateway.try_submit(stuck, stuck_sent, order);
+            if (result == SubmitResult::FULL && stuck_sent > 4)
+                break;
+            stuck_sent += result == SubmitResult::QUEUED;
+            std::this_thread::yield();
+        }
+        CHECK(gateway.try_submit(stuck, stuck_sent, order) == SubmitResult::FULL);
+
+        const uint64_t commands_per_client = 2000;
+        std::vector<uint64_t> received(others + 1, 0);
+        std::vector<std::thread> producers;
+        for (int c = 1; c <= others; c++)
+        {
+            producers.emplace_back([&gateway, &received, &deadline, &order, c, commands_per_client]()
+            {
+                uint64_t sent = 0;
+                while (received[c] < commands_per_client && Clock::now() < deadline)
+                {
+                    if (sent < commands_per_client && gateway.try_submit(c, sent, order) == SubmitResult::QUEUED)
+                        sent++;
+                    GatewayResponse response;
+                    while (gateway.try_receive(c, response))
+                        received[c] += response.tag == received[c];
+                    std::this_thread::yield();
+                }
+            });
+        }
+        for (std::thread &producer : producers)
+            producer.join();
+        for (int c = 1; c <= others; c++)
+            CHECK(received[c] == commands_per_client);
+
+        // Reading again releases the parked responses, in order, and the client may submit again
+        GatewayResponse response;
+        while (received[stuck] < stuck_sent && Clock::now() < deadline)
+        {
+            if (gateway.try_receive(stuck, response))
+                received[stuck] += response.tag == received[stuck];
+            else
+                std::this_thread::yield();
+        }
+        CHECK(received[stuck] == stuck_sent);
+        while (gateway.try_submit(stuck, stuck_sent, order) == SubmitResult::FULL && Clock::now() < deadline)
+            std::this_thread::yield();
+        gateway.stop();
+
+        CHECK(gateway.try_receive(stuck, response) && response.tag == stuck_sent);
+        CHECK(gateway.get_dropped_responses() == 0);
+    }
+
+    void run(const char *name, void (*test)())
+    {
+        int before = failures;
+        test();
+        std::cout << (failures == before ? "PASS " : "FAIL ") << name << std::endl;
+    }
+}
+
+int main()
+{
+    run("validate_mid_day_file", test_validate_mid_day_file);
+    run("ladder_matches_map_levels", test_ladder_matches_map_levels);
+    run("ladder_matches_map_book", test_ladder_matches_map_book);
+    run("queue_unlinks_any_order", test_queue_unlinks_any_order);
+    run("cancel_keeps_time_priority", test_cancel_keeps_time_priority);
+    run("id_index_matches_map", test_id_index_matches_map);
+    run("dense_index_ignores_out_of_range_ids", test_dense_index_ignores_out_of_range_ids);
+    run("reduce_rejects_non_positive_quantity", test_reduce_rejects_non_positive_quantity);
+    run("fill_rejects_non_positive_quantity", test_fill_rejects_non_positive_quantity);
+    run("batch_matches_single_calls", test_batch_matches_single_calls);
+    run("replay_blocks_match_message_replay", test_replay_blocks_match_message_replay);
+    run("snapshot_rejects_invalid_records", test_snapshot_rejects_invalid_records);
+    run("snapshot_matches_its_message_file", test_snapshot_matches_its_message_file);
+    run("book_snapshot_round_trip", test_book_snapshot_round_trip);
+    run("replay_snapshot_round_trip", test_replay_snapshot_round_trip);
+    run("seek_matches_full_replay", test_seek_matches_full_replay);
+    run("parser_rejects_non_positive_size", test_parser_rejects_non_positive_size);
+    run("gateway_acknowledges_each_command_once", test_gateway_acknowledges_each_command_once);
+    run("gateway_rejects_invalid_submissions", test_gateway_rejects_invalid_submissions);
+    run("gateway_stops_with_undrained_client", test_gateway_stops_with_undrained_client);
+    run("gateway_serves_others_past_undrained_client", test_gateway_serves_others_past_undrained_client);
+
+    std::cout << (failures == 0 ? "All tests passed" : "Tests failed") << std::endl;
+    return failures;
+}
@@ -0,0 +1,182 @@
+#include "lobster_cache.h"
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <vector>
+
+namespace
+{
+    // Records converted per write call
+    constexpr size_t WRITE_BATCH_RECORDS = 4096;
+
+    // Bytes read per call when hashing a file that is not mapped; a multiple of a word
+    constexpr size_t HASH_CHUNK_BYTES = 1 << 20;
+
+    constexpr uint64_t HASH_MULTIPLIER = 0x9E3779B97F4A7C15ull;
+
+    // Mixes the whole words of a chunk into a hash; returns the number of bytes consumed
+    size_t hash_words(uint64_t &hash, const char *data, size_t size)
+    {
+        size_t i = 0;
+        for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+        {
+            uint64_t word;
+            std::memcpy(&word, data + i, sizeof(word));
+            hash = (hash ^ word) * HASH_MULTIPLIER;
+            hash ^= hash >> 29;
+        }
+        return i;
+    }
+
+    // Mixes in the final partial word (size < 8, possibly 0) and finalises the hash
+    uint64_t finish_hash(uint64_t hash, const char *tail, size_t size)
+    {
+        uint64_t word = 0;
+        if (size > 0)
+            std::memcpy(&word, tail, size);
+        hash = (hash ^ word) * HASH_MULTIPLIER;
+        return hash ^ (hash >> 32);
+    }
+
+    int64_t last_write_ns(const std::string &filename, std::error_code &error)
+    {
+        auto modified = std::filesystem::last_write_time(filename, error);
+        if (error)
+            return 0;
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(modified.time_since_epoch()).count();
+    }
+}
+
+std::string lobster_cache_path(const std::string &csv_filename)
+{
+    const std::string extension = ".csv";
+    if (csv_filename.size() > extension.size() &&
+        csv_filename.compare(csv_filename.size() - extension.size(), extension.size(), extension) == 0)
+    {
+        return csv_filename.substr(0, csv_filename.size() - extension.size()) + ".lobc";
+    }
+    return csv_filename + ".lobc";
+}
+
+uint64_t hash_lobster_source(const char *data, size_t size)
+{
+    uint64_t hash = size * HASH_MULTIPLIER;
+    size_t used = hash_words(hash, data, size);
+    return finish_hash(hash, data + used, size - used);
+}
+
+LobsterSourceStamp stamp_lobster_source(const std::string &filename, const char *data, size_t size)
+{
+    LobsterSourceStamp stamp{};
+    stamp.bytes = size;
+
+    std::error_code error;
+    stamp.modified_ns = last_write_ns(filename, error);
+    stamp.hash = hash_lobster_source(data, size);
+    return stamp;
+}
+
+LobsterSourceStamp stamp_lobster_file(const std::string &filename)
+{
+    LobsterSourceStamp stamp{};
+    std::error_code error;
+    uint64_t size = std::filesystem::file_size(filename, error);
+    std::ifstream file(filename, std::ios::binary);
+    if (error || !file)
+        return stamp;
+
+    stamp.bytes = size;
+    stamp.modified_ns = last_write_ns(filename, error);
+
+    // Whole chunks are a multiple of a word, so only the last one can leave a tail
+    uint64_t hash = size * HASH_MULTIPLIER;
+    std::vector<char> chunk(HASH_CHUNK_BYTES);
+    size_t tail = 0;
+    size_t tail_size = 0;
+    while (tail_size == 0 && (file.read(chunk.data(), static_cast<std::streamsize>(chunk.size())) || file.gcount() > 0))
+    {
+        size_t read = static_cast<size_t>(file.gcount());
+        tail = hash_words(hash, chunk.data(), read);
+        tail_size = read - tail;
+    }
+    stamp.hash = finish_hash(hash, chunk.data() + tail, tail_size);
+    return stamp;
+}
+
+bool lobster_source_matches(const LobsterSourceStamp &stamp, const std::string &filename,
+                            const char *data, size_t size)
+{
+    if (stamp.bytes != size)
+        return false;
+
+    std::error_code error;
+    int64_t modified = last_write_ns(filename, error);
+    if (error || modified != stamp.modified_ns)
+        return false;
+
+    return hash_lobster_source(data, size) == stamp.hash;
+}
+
+bool same_lobster_source(const LobsterSourceStamp &a, const LobsterSourceStamp &b)
+{
+    return a.bytes == b.bytes && a.modified_ns == b.modified_ns && a.hash == b.hash;
+}
+
+const LobsterCacheHeader *read_lobster_cache_header(const char *data, size_t size)
+{
+    if (!data || size < sizeof(LobsterCacheHeader))
+        return nullptr;
+
+    const LobsterCacheHeader *header = reinterpret_cast<const LobsterCacheHeader *>(data);
+    if (std::memcmp(header->magic, LOBSTER_CACHE_MAGIC, sizeof(LOBSTER_CACHE_MAGIC)) != 0 ||
+        header->version != LOBSTER_CACHE_VERSION || header->record_size != sizeof(LobsterRecord))
+        return nullptr;
+
+    // A truncated file would hand out records past the end of the mapping
+    if ((size - sizeof(LobsterCacheHeader)) / sizeof(LobsterRecord) < header->message_count)
+        return nullptr;
+
+    return header;
+}
+
+bool write_lobster_cache(const std::string &filename, const std::vector<LobsterMessage> &messages,
+                         const LobsterStats &stats, const LobsterSourceStamp &source)
+{
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+        return false;
+
+    LobsterCacheHeader header{};
+    std::memcpy(header.magic, LOBSTER_CACHE_MAGIC, sizeof(LOBSTER_CACHE_MAGIC));
+    header.version = LOBSTER_CACHE_VERSION;
+    header.record_size = sizeof(LobsterRecord);
+    header.source = source;
+    header.message_count = messages.size();
+    header.stats = stats;
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    std::vector<LobsterRecord> batch;
+    batch.reserve(WRITE_BATCH_RECORDS);
+    for (size_t i = 0; i < messages.size(); i += batch.size())
+    {
+        batch.clear();
+        for (size_t j = i; j < messages.size() && batch.size() < WRITE_BATCH_RECORDS; j++)
+        {
+            const LobsterMessage &msg = messages[j];
+            LobsterRecord record{};
+            record.timestamp = msg.timestamp;
+            record.price = msg.price;
+            record.order_id = msg.order_id;
+            record.size = msg.size;
+            record.type = static_cast<int8_t>(msg.type);
+            record.direction = static_cast<int8_t>(msg.direction);
+            batch.push_back(record);
+        }
+        file.write(reinterpret_cast<const char *>(batch.data()),
+                   static_cast<std::streamsize>(batch.size() * sizeof(LobsterRecord)));
+    }
+
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,139 @@
+#ifndef LOBSTER_CACHE_H
+#define LOBSTER_CACHE_H
+
+#include "lobster_parser.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @struct LobsterRecord
+ * @brief Fixed-width on-disk form of a LobsterMessage in a binary cache file.
+ */
+struct LobsterRecord
+{
+    double timestamp;     // Time in seconds after midnight
+    Price price;          // Price in ticks
+    int32_t order_id;     // LOBSTER order id
+    int32_t size;         // Number of shares
+    int8_t type;          // LobsterMessageType value
+    int8_t direction;     // 1 = buy, -1 = sell
+    uint8_t reserved[6];  // Zero; pads the record to 32 bytes
+};
+
+static_assert(sizeof(LobsterRecord) == 32, "LobsterRecord layout is part of the file format");
+
+/**
+ * @struct LobsterCacheHeader
+ * @brief Header at the start of a binary cache file, followed by message_count records.
+ *
+ * Everything is stored in host byte order; the magic and version reject files written
+ * by an incompatible build. The header carries the file's statistics, so they are
+ * available without touching the records.
+ */
+struct LobsterCacheHeader
+{
+    char magic[8];             // LOBSTER_CACHE_MAGIC
+    uint32_t version;          // LOBSTER_CACHE_VERSION
+    uint32_t record_size;      // sizeof(LobsterRecord)
+    LobsterSourceStamp source; // The CSV the cache was built from
+    uint64_t message_count;    // Number of records that follow
+    LobsterStats stats;        // Statistics of all messages
+};
+
+static_assert(sizeof(LobsterCacheHeader) % alignof(LobsterRecord) == 0,
+              "records must stay aligned after the header");
+
+/** Identifies a binary LOBSTER cache file. */
+constexpr char LOBSTER_CACHE_MAGIC[8] = {'L', 'O', 'B', 'C', 'A', 'C', 'H', 'E'};
+
+/** Current cache format version. */
+constexpr uint32_t LOBSTER_CACHE_VERSION = 2;
+
+/**
+ * @brief Converts a cache record back into a message.
+ * @param record The record to convert.
+ * @return The message the record stores.
+ */
+inline LobsterMessage message_from_record(const LobsterRecord &record)
+{
+    return LobsterMessage(record.timestamp, static_cast<LobsterMessageType>(record.type),
+                          record.order_id, record.size, record.price, record.direction);
+}
+
+/**
+ * @brief Gets the default cache path for a CSV file ("x.csv" -> "x.lobc").
+ * @param csv_filename Path to the CSV message file.
+ * @return Path of its binary cache.
+ */
+std::string lobster_cache_path(const std::string &csv_filename);
+
+/**
+ * @brief Hashes file contents, eight bytes at a time.
+ * @param data Start of the contents.
+ * @param size Size of the contents in bytes.
+ * @return A 64-bit hash of the contents.
+ */
+uint64_t hash_lobster_source(const char *data, size_t size);
+
+/**
+ * @brief Stamps a CSV file so a cache built from it can later be matched to it.
+ * @param filename Path of the file, for its last write time.
+ * @param data Start of the file contents.
+ * @param size Size of the file in bytes.
+ * @return The file's size, last write time and content hash.
+ */
+LobsterSourceStamp stamp_lobster_source(const std::string &filename, const char *data, size_t size);
+
+/**
+ * @brief Stamps a CSV file like stamp_lobster_source, reading it in chunks instead of mapping it.
+ *
+ * Used for streamed files, so hashing does not leave the whole file resident.
+ * @param filename Path of the file.
+ * @return The file's size, last write time and content hash, or a zero stamp if it cannot be read.
+ */
+LobsterSourceStamp stamp_lobster_file(const std::string &filename);
+
+/**
+ * @brief Checks that a CSV file is still the one a cache was built from.
+ *
+ * Size and last write time are compared first; the contents are hashed only when both
+ * match, so a stale cache is usually rejected without reading the CSV.
+ * @param stamp The stamp stored in the cache.
+ * @param filename Path of the CSV file.
+ * @param data Start of the CSV contents.
+ * @param size Size of the CSV in bytes.
+ * @return True if size, last write time and content hash all match.
+ */
+bool lobster_source_matches(const LobsterSourceStamp &stamp, const std::string &filename,
+                            const char *data, size_t size);
+
+/**
+ * @brief Compares two stamps field by field.
+ * @param a A stamp.
+ * @param b Another stamp.
+ * @return True if size, last write time and content hash all match.
+ */
+bool same_lobster_source(const LobsterSourceStamp &a, const LobsterSourceStamp &b);
+
+/**
+ * @brief Validates the header of a mapped file.
+ * @param data Start of the file contents.
+ * @param size Size of the file in bytes.
+ * @return The header if the file is a complete cache of this version, nullptr otherwise.
+ */
+const LobsterCacheHeader *read_lobster_cache_header(const char *data, size_t size);
+
+/**
+ * @brief Writes messages and their statistics to a binary cache file.
+ * @param filename Path of the cache file to create.
+ * @param messages Messages to store, in order.
+ * @param stats Statistics of the messages.
+ * @param source Stamp of the CSV file the messages were parsed from.
+ * @return True if the file was written completely, false otherwise.
+ */
+bool write_lobster_cache(const std::string &filename, const std::vector<LobsterMessage> &messages,
+                         const LobsterStats &stats, const LobsterSourceStamp &source);
+
+#endif // LOBSTER_CACHE_H
@@ -0,0 +1,119 @@
+#include "lobster_orderbook.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    // Parses one integer column and the separator after it
+    template <typename Int>
+    void parse_column(const char *&p, const char *end, Int &value, bool last)
+    {
+        auto result = std::from_chars(p, end, value);
+        if (result.ec != std::errc())
+            throw std::runtime_error("Invalid numeric field in orderbook row");
+        p = result.ptr;
+
+        if (last)
+        {
+            if (p != end)
+                throw std::runtime_error("Orderbook row has more columns than the first row");
+        }
+        else
+        {
+            if (p == end || *p != ',')
+                throw std::runtime_error("Orderbook row has fewer columns than the first row");
+            p++;
+        }
+    }
+
+    // End of the line starting at p, excluding any '\r'
+    const char *line_end(const char *p, const char *end, const char *&next)
+    {
+        const char *newline = static_cast<const char *>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+        next = newline ? newline + 1 : end;
+        const char *stop = newline ? newline : end;
+        if (stop > p && stop[-1] == '\r')
+            stop--;
+        return stop;
+    }
+}
+
+LobsterOrderbookReader::LobsterOrderbookReader()
+    : position(nullptr), levels(0), line_number(0), discarded_through(0) {}
+
+bool LobsterOrderbookReader::open(const std::string &filename)
+{
+    levels = 0;
+    line_number = 0;
+    discarded_through = 0;
+    if (!file.open(filename) || file.size() == 0)
+        return false;
+
+    position = file.data();
+    const char *next;
+    const char *stop = line_end(position, file.data() + file.size(), next);
+
+    size_t columns = 1 + static_cast<size_t>(std::count(position, stop, ','));
+    if (columns % 4 != 0)
+        return false;
+
+    levels = columns / 4;
+    return true;
+}
+
+size_t LobsterOrderbookReader::get_levels() const
+{
+    return levels;
+}
+
+size_t LobsterOrderbookReader::get_line_number() const
+{
+    return line_number;
+}
+
+bool LobsterOrderbookReader::next_row(DepthLevel *out)
+{
+    const char *end = file.data() + file.size();
+    if (levels == 0 || position >= end)
+        return false;
+
+    const char *next;
+    const char *stop = line_end(position, end, next);
+    const char *p = position;
+    position = next;
+    line_number++;
+
+    for (size_t i = 0; i < levels; i++)
+    {
+        bool last = i + 1 == levels;
+        parse_column(p, stop, out[i].ask_price, false);
+        parse_column(p, stop, out[i].ask_size, false);
+        parse_column(p, stop, out[i].bid_price, false);
+        parse_column(p, stop, out[i].bid_size, last);
+    }
+
+    // Rows are never revisited, so release what has been read
+    size_t offset = static_cast<size_t>(position - file.data());
+    if (offset - discarded_through >= DISCARD_INTERVAL)
+    {
+        file.discard_before(offset);
+        discarded_through = offset;
+    }
+
+    return true;
+}
+
+bool depth_equal(const DepthLevel *a, const DepthLevel *b, size_t levels)
+{
+    uint64_t difference = 0;
+    for (size_t i = 0; i < levels; i++)
+    {
+        difference |= static_cast<uint64_t>(a[i].ask_price ^ b[i].ask_price) |
+                      static_cast<uint64_t>(a[i].bid_price ^ b[i].bid_price) |
+                      static_cast<uint32_t>(a[i].ask_size ^ b[i].ask_size) |
+                      static_cast<uint32_t>(a[i].bid_size ^ b[i].bid_size);
+    }
+    return difference == 0;
+}
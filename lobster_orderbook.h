@@ -0,0 +1,77 @@
+#ifndef LOBSTER_ORDERBOOK_H
+#define LOBSTER_ORDERBOOK_H
+
+#include "lob.h"
+#include "mapped_file.h"
+#include <cstddef>
+#include <string>
+
+/**
+ * @class LobsterOrderbookReader
+ * @brief Streams a LOBSTER orderbook_*.csv file one row at a time.
+ *
+ * Every row holds the top N levels after the message on the same line of the message
+ * file: ask price, ask size, bid price, bid size for level 1, then level 2 and so on.
+ * The file is memory-mapped and pages behind the read position are released as the
+ * reader advances, so full days can be validated in constant memory.
+ */
+class LobsterOrderbookReader
+{
+public:
+    /** Bytes read between releases of already-parsed pages. */
+    static constexpr size_t DISCARD_INTERVAL = size_t(64) << 20;
+
+private:
+    MappedFile file;
+    const char *position;     // Start of the next row
+    size_t levels;            // Levels per side in every row
+    size_t line_number;       // Line number of the last row read
+    size_t discarded_through; // Offset up to which pages have been released
+
+public:
+    /**
+     * @brief Constructs a reader with no file open.
+     */
+    LobsterOrderbookReader();
+
+    /**
+     * @brief Opens an orderbook file and detects its level count from the first row.
+     * @param filename Path of the orderbook file.
+     * @return False if the file cannot be opened or its first row is not 4N columns.
+     */
+    bool open(const std::string &filename);
+
+    /**
+     * @brief Gets the number of levels per side in each row.
+     * @return The level count, 0 if no file is open.
+     */
+    size_t get_levels() const;
+
+    /**
+     * @brief Gets the line number of the row returned by the last next_row call.
+     * @return The 1-based line number.
+     */
+    size_t get_line_number() const;
+
+    /**
+     * @brief Parses the next row.
+     * @param out Buffer of get_levels() entries receiving the row.
+     * @return False at the end of the file.
+     * @throws std::runtime_error if the row is malformed.
+     */
+    bool next_row(DepthLevel *out);
+};
+
+/**
+ * @brief Compares two depth snapshots.
+ *
+ * The loop has no early exit so the compiler can vectorize it; snapshots are
+ * almost always equal, so scanning the whole buffer costs nothing extra.
+ * @param a First snapshot.
+ * @param b Second snapshot.
+ * @param levels Number of levels in each.
+ * @return True if every price and size matches.
+ */
+bool depth_equal(const DepthLevel *a, const DepthLevel *b, size_t levels);
+
+#endif // LOBSTER_ORDERBOOK_H
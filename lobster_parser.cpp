@@ -1,14 +1,83 @@
 #include "lobster_parser.h"
-#include <fstream>
-#include <sstream>
+#include "lobster_cache.h"
+#include "mapped_file.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <iomanip>
+#include <stdexcept>
+#include <thread>
+
+namespace
+{
+    // Typical LOBSTER message line length, used to pre-size the message vector
+    constexpr size_t ESTIMATED_LINE_BYTES = 40;
+
+    // Parses an integer field and consumes the comma after it (unless it is the last field)
+    template <typename Int>
+    void parse_field(const char *&p, const char *end, Int &value, bool last)
+    {
+        auto result = std::from_chars(p, end, value);
+        if (result.ec != std::errc())
+            throw std::runtime_error("Invalid numeric field");
+        p = result.ptr;
+
+        if (last)
+        {
+            if (p != end)
+                throw std::runtime_error("Invalid LOBSTER message format: expected 6 columns");
+        }
+        else
+        {
+            if (p == end || *p != ',')
+                throw std::runtime_error("Invalid LOBSTER message format: expected 6 columns");
+            p++;
+        }
+    }
+
+    // Parses "seconds[.fraction]" as fixed point, without going through strtod
+    double parse_timestamp(const char *&p, const char *end)
+    {
+        long long seconds = 0;
+        auto result = std::from_chars(p, end, seconds);
+        if (result.ec != std::errc())
+            throw std::runtime_error("Invalid timestamp");
+        p = result.ptr;
+
+        long long fraction = 0;
+        long long scale = 1;
+        if (p != end && *p == '.')
+        {
+            p++;
+            // Nanosecond resolution is all LOBSTER provides; ignore any further digits
+            for (; p != end && *p >= '0' && *p <= '9'; p++)
+            {
+                if (scale < 1000000000LL)
+                {
+                    fraction = fraction * 10 + (*p - '0');
+                    scale *= 10;
+                }
+            }
+        }
+
+        if (p == end || *p != ',')
+            throw std::runtime_error("Invalid LOBSTER message format: expected 6 columns");
+        p++;
+
+        return static_cast<double>(seconds) + static_cast<double>(fraction) / static_cast<double>(scale);
+    }
+}
 
 LobsterMessage::LobsterMessage(double timestamp, LobsterMessageType type, int order_id,
-                               int size, double price, int direction)
+                               int size, Price price, int direction)
     : timestamp(timestamp), type(type), order_id(order_id),
       size(size), price(price), direction(direction) {}
 
+LobsterMessage::LobsterMessage() : LobsterMessage(0, LobsterMessageType::NEW_ORDER, 0, 0, 0, 1) {}
+
 OrderSide LobsterMessage::get_order_side() const
 {
     return (direction == 1) ? OrderSide::BUY : OrderSide::SELL;
@@ -35,36 +104,30 @@ std::string LobsterMessage::type_to_string() const
     }
 }
 
-LobsterParser::LobsterParser() : current_index(0) {}
+LobsterParser::LobsterParser()
+    : source(Source::MEMORY), current_index(0), stats(), source_stamp(), stamp_pending(false), stream_pos(nullptr),
+      stream_consumed(0), read_ahead(DEFAULT_READ_AHEAD), batch_offset(0), batch_line(0), cache_records(nullptr), cache_count(0),
+      line_number(0), failed_lines(0), parse_threads(1) {}
 
-double LobsterParser::convert_price(int price_raw)
+Price LobsterParser::convert_price(long long price_raw) const
 {
-    return static_cast<double>(price_raw) / 10000.0;
+    // LOBSTER prices are already dollars x 10000, which is our tick size
+    return static_cast<Price>(price_raw);
 }
 
-LobsterMessage LobsterParser::parse_line(const std::string &line)
+LobsterMessage LobsterParser::parse_line(const char *begin, const char *end) const
 {
-    std::stringstream ss(line);
-    std::string token;
-    std::vector<std::string> tokens;
-
-    // Split by comma
-    while (std::getline(ss, token, ','))
-    {
-        tokens.push_back(token);
-    }
-
-    if (tokens.size() != 6)
-    {
-        throw std::runtime_error("Invalid LOBSTER message format: expected 6 columns");
-    }
-
-    double timestamp = std::stod(tokens[0]);
-    int type_raw = std::stoi(tokens[1]);
-    int order_id = std::stoi(tokens[2]);
-    int size = std::stoi(tokens[3]);
-    int price_raw = std::stoi(tokens[4]);
-    int direction = std::stoi(tokens[5]);
+    // Fields are converted straight out of the file buffer; nothing is copied
+    const char *p = begin;
+    int type_raw, order_id, size, direction;
+    long long price_raw;
+
+    double timestamp = parse_timestamp(p, end);
+    parse_field(p, end, type_raw, false);
+    parse_field(p, end, order_id, false);
+    parse_field(p, end, size, false);
+    parse_field(p, end, price_raw, false);
+    parse_field(p, end, direction, true);
 
     // Validate message type
     LobsterMessageType type;
@@ -98,71 +161,343 @@ LobsterMessage LobsterParser::parse_line(const std::string &line)
         throw std::runtime_error("Invalid direction: must be 1 or -1");
     }
 
-    double price = convert_price(price_raw);
+    // Every message but a halt moves shares; a non-positive size would grow the order it names
+    if (size <= 0 && type != LobsterMessageType::TRADING_HALT)
+    {
+        throw std::runtime_error("Invalid size: must be positive");
+    }
+
+    Price price = convert_price(price_raw);
 
     return LobsterMessage(timestamp, type, order_id, size, price, direction);
 }
 
-bool LobsterParser::load_file(const std::string &filename)
+size_t LobsterParser::parse_range(const char *&p, const char *end, size_t max_messages,
+                                  ParsedChunk &chunk) const
 {
-    std::ifstream file(filename);
-    if (!file.is_open())
+    size_t parsed = 0;
+
+    while (p < end && parsed < max_messages)
+    {
+        const char *eol = static_cast<const char *>(std::memchr(p, '\n', end - p));
+        if (!eol)
+            eol = end;
+
+        chunk.lines++;
+        const char *line_end = eol;
+        if (line_end > p && line_end[-1] == '\r')
+            line_end--;
+
+        // Skip empty lines
+        if (line_end != p)
+        {
+            try
+            {
+                chunk.messages.push_back(parse_line(p, line_end));
+                parsed++;
+            }
+            catch (const std::exception &e)
+            {
+                chunk.failures.push_back(ParseFailure{chunk.lines, e.what(), std::string(p, line_end)});
+            }
+        }
+
+        p = eol < end ? eol + 1 : end;
+    }
+
+    return parsed;
+}
+
+size_t LobsterParser::parse_lines(const char *&p, const char *end, size_t max_messages)
+{
+    // Parse straight into the message vector rather than a separate chunk
+    ParsedChunk chunk;
+    chunk.messages.swap(messages);
+    size_t parsed = parse_range(p, end, max_messages, chunk);
+    chunk.messages.swap(messages);
+
+    report_failures(chunk.failures, line_number);
+    line_number += chunk.lines;
+    return parsed;
+}
+
+size_t LobsterParser::parse_parallel(const char *begin, const char *end, unsigned threads)
+{
+    // Cut the text into one chunk per thread, each ending just after a newline
+    std::vector<const char *> bounds{begin};
+    size_t chunk_bytes = static_cast<size_t>(end - begin) / threads;
+    for (unsigned i = 1; i < threads; i++)
+    {
+        const char *cut = std::max(bounds.back(), begin + i * chunk_bytes);
+        const char *eol = cut < end ? static_cast<const char *>(std::memchr(cut, '\n', end - cut)) : nullptr;
+        bounds.push_back(eol ? eol + 1 : end);
+    }
+    bounds.push_back(end);
+
+    size_t chunk_count = bounds.size() - 1;
+    std::vector<ParsedChunk> chunks(chunk_count);
+    auto parse_chunk = [&](size_t i)
+    {
+        const char *p = bounds[i];
+        chunks[i].messages.reserve(static_cast<size_t>(bounds[i + 1] - p) / ESTIMATED_LINE_BYTES + 1);
+        parse_range(p, bounds[i + 1], SIZE_MAX, chunks[i]);
+    };
+
+    // The calling thread parses the first chunk itself
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < chunk_count; i++)
+        workers.emplace_back(parse_chunk, i);
+    parse_chunk(0);
+    for (std::thread &worker : workers)
+        worker.join();
+
+    // Stitch the chunks back together in file order
+    size_t total = 0;
+    for (const ParsedChunk &chunk : chunks)
+        total += chunk.messages.size();
+    messages.reserve(messages.size() + total);
+
+    for (ParsedChunk &chunk : chunks)
+    {
+        messages.insert(messages.end(), chunk.messages.begin(), chunk.messages.end());
+        report_failures(chunk.failures, line_number);
+        line_number += chunk.lines;
+        std::vector<LobsterMessage>().swap(chunk.messages);
+    }
+
+    return total;
+}
+
+void LobsterParser::report_failures(const std::vector<ParseFailure> &failures, int first_line)
+{
+    for (const ParseFailure &failure : failures)
+    {
+        std::cerr << "Warning: Failed to parse line " << first_line + failure.line_number
+                  << ": " << failure.error << std::endl;
+        std::cerr << "Line content: " << failure.content << std::endl;
+        failed_lines++;
+    }
+}
+
+bool LobsterParser::load_file(const std::string &filename, bool use_cache)
+{
+    MappedFile file;
+    if (!file.open(filename))
     {
         std::cerr << "Error: Cannot open file " << filename << std::endl;
         return false;
     }
 
+    auto start_time = std::chrono::steady_clock::now();
+
+    source_file.close();
+    source = Source::MEMORY;
+    stream_pos = nullptr;
+    stream_consumed = 0;
+    cache_records = nullptr;
+    cache_count = 0;
     messages.clear();
     current_index = 0;
-
-    std::string line;
-    int line_number = 0;
-    int successful_parses = 0;
-
-    while (std::getline(file, line))
+    line_number = 0;
+    failed_lines = 0;
+
+    // Prefer a cache over parsing: either the file is one, or the CSV has an up-to-date one
+    bool is_cache = read_lobster_cache_header(file.data(), file.size()) != nullptr;
+    std::string cache_filename = is_cache ? filename : lobster_cache_path(filename);
+    bool cached = is_cache ? open_cache(filename, "", nullptr)
+                           : use_cache && open_cache(cache_filename, filename, &file);
+    if (cached)
     {
-        line_number++;
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+        std::cout << "Loaded " << cache_count << " messages from cache "
+                  << cache_filename << std::endl;
+        print_throughput(source_file.size(), cache_count, seconds);
+        return cache_count > 0;
+    }
 
-        // Skip empty lines
-        if (line.empty())
-            continue;
+    const char *p = file.data();
+    size_t successful_parses;
 
-        try
-        {
-            LobsterMessage message = parse_line(line);
-            messages.push_back(message);
-            successful_parses++;
-        }
-        catch (const std::exception &e)
-        {
-            std::cerr << "Warning: Failed to parse line " << line_number
-                      << ": " << e.what() << std::endl;
-            std::cerr << "Line content: " << line << std::endl;
-        }
+    unsigned threads = static_cast<unsigned>(std::min<size_t>(parse_threads, file.size() / MIN_CHUNK_BYTES + 1));
+    if (threads > 1)
+        successful_parses = parse_parallel(p, p + file.size(), threads);
+    else
+    {
+        messages.reserve(file.size() / ESTIMATED_LINE_BYTES + 1);
+        successful_parses = parse_lines(p, p + file.size(), SIZE_MAX);
     }
+    compute_stats();
+    source_stamp = stamp_lobster_source(filename, file.data(), file.size());
+    stamp_pending = false;
 
-    file.close();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
 
     std::cout << "Loaded " << successful_parses << " messages from "
-              << filename << std::endl;
+              << filename;
+    if (threads > 1)
+        std::cout << " using " << threads << " threads";
+    std::cout << std::endl;
+    print_throughput(file.size(), successful_parses, seconds);
 
-    if (line_number > successful_parses)
+    if (failed_lines > 0)
     {
-        std::cout << "Warning: " << (line_number - successful_parses)
+        std::cout << "Warning: " << failed_lines
                   << " lines could not be parsed" << std::endl;
     }
 
     return successful_parses > 0;
 }
 
+bool LobsterParser::write_cache(const std::string &filename) const
+{
+    // Only a file parsed into memory has every message at hand
+    if (source != Source::MEMORY || messages.empty())
+        return false;
+    return write_lobster_cache(filename, messages, stats, source_stamp);
+}
+
+void LobsterParser::set_parse_threads(unsigned threads)
+{
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency();
+    parse_threads = threads > 0 ? threads : 1;
+}
+
+bool LobsterParser::open_cache(const std::string &filename, const std::string &csv_filename, const MappedFile *csv)
+{
+    if (!source_file.open(filename))
+        return false;
+
+    const LobsterCacheHeader *header = read_lobster_cache_header(source_file.data(), source_file.size());
+    if (!header)
+    {
+        source_file.close();
+        return false;
+    }
+
+    // A CSV rewritten since the cache was built must be parsed again, even at the same size
+    if (!csv_filename.empty() && !lobster_source_matches(header->source, csv_filename, csv->data(), csv->size()))
+    {
+        std::cout << "Ignoring stale cache " << filename << ": " << csv_filename
+                  << " changed since it was built" << std::endl;
+        source_file.close();
+        return false;
+    }
+
+    source = Source::CACHE;
+    cache_records = reinterpret_cast<const LobsterRecord *>(source_file.data() + sizeof(LobsterCacheHeader));
+    cache_count = header->message_count;
+    stats = header->stats;
+    source_stamp = header->source;
+    stamp_pending = false;
+
+    // Records are read straight from the mapping; the message vector is not needed
+    messages.clear();
+    messages.shrink_to_fit();
+    current_index = 0;
+    return true;
+}
+
+bool LobsterParser::open_stream(const std::string &filename, size_t read_ahead)
+{
+    // A cache is already read from the mapping without parsing; use it as is
+    if (open_cache(filename, "", nullptr))
+    {
+        std::cout << "Loaded " << cache_count << " messages from cache " << filename << std::endl;
+        return true;
+    }
+
+    if (!source_file.open(filename))
+    {
+        std::cerr << "Error: Cannot open file " << filename << std::endl;
+        return false;
+    }
+
+    source = Source::STREAM;
+    source_stamp = LobsterSourceStamp();
+    source_stamp.bytes = source_file.size();
+    stamp_pending = true;
+    stream_filename = filename;
+    this->read_ahead = read_ahead > 0 ? read_ahead : 1;
+    stats = LobsterStats();
+    cache_records = nullptr;
+    cache_count = 0;
+
+    // Drop any fully loaded file; the buffer never holds more than one batch from here on
+    messages.clear();
+    messages.shrink_to_fit();
+    messages.reserve(this->read_ahead);
+    reset();
+
+    std::cout << "Streaming " << filename << " (" << std::fixed << std::setprecision(1)
+              << static_cast<double>(source_file.size()) / (1024.0 * 1024.0) << " MB, "
+              << this->read_ahead << " message read-ahead)" << std::endl;
+    return true;
+}
+
+bool LobsterParser::is_streaming() const
+{
+    return source == Source::STREAM;
+}
+
+bool LobsterParser::refill_stream()
+{
+    stream_consumed += messages.size();
+    messages.clear();
+    current_index = 0;
+
+    const char *end = source_file.data() + source_file.size();
+    if (stream_pos && stream_pos < end)
+    {
+        batch_offset = static_cast<size_t>(stream_pos - source_file.data());
+        batch_line = line_number;
+        parse_lines(stream_pos, end, read_ahead);
+
+        // Pages behind the parse position will not be read again until a reset or seek
+        source_file.discard_before(static_cast<size_t>(stream_pos - source_file.data()));
+    }
+
+    return !messages.empty();
+}
+
+void LobsterParser::print_throughput(size_t bytes, size_t message_count, double seconds)
+{
+    double megabytes = static_cast<double>(bytes) / (1024.0 * 1024.0);
+    std::cout << "Parsed " << std::fixed << std::setprecision(1) << megabytes << " MB in "
+              << std::setprecision(3) << seconds << "s";
+    if (seconds > 0)
+    {
+        std::cout << " (" << std::setprecision(1) << megabytes / seconds << " MB/s, "
+                  << std::setprecision(0) << message_count / seconds << " msgs/s)";
+    }
+    std::cout << std::endl;
+}
+
 void LobsterParser::reset()
 {
     current_index = 0;
+
+    // A stream restarts by re-parsing from the top of the file
+    if (source == Source::STREAM)
+    {
+        messages.clear();
+        stream_pos = source_file.data();
+        source_file.rewind(0);
+        stream_consumed = 0;
+        batch_offset = 0;
+        batch_line = 0;
+        line_number = 0;
+        failed_lines = 0;
+    }
 }
 
-bool LobsterParser::has_next_message() const
+bool LobsterParser::has_next_message()
 {
-    return current_index < messages.size();
+    if (source == Source::CACHE)
+        return current_index < cache_count;
+    if (current_index < messages.size())
+        return true;
+    return source == Source::STREAM && refill_stream();
 }
 
 LobsterMessage LobsterParser::get_next_message()
@@ -172,90 +507,162 @@ LobsterMessage LobsterParser::get_next_message()
         throw std::runtime_error("No more messages available");
     }
 
+    if (source == Source::CACHE)
+        return message_from_record(cache_records[current_index++]);
     return messages[current_index++];
 }
 
+LobsterMessage LobsterParser::peek_next_message()
+{
+    if (!has_next_message())
+    {
+        throw std::runtime_error("No more messages available");
+    }
+
+    if (source == Source::CACHE)
+        return message_from_record(cache_records[current_index]);
+    return messages[current_index];
+}
+
 size_t LobsterParser::get_total_messages() const
 {
-    return messages.size();
+    if (source == Source::CACHE)
+        return cache_count;
+    return stream_consumed + messages.size();
 }
 
 size_t LobsterParser::get_current_index() const
 {
-    return current_index;
+    return stream_consumed + current_index;
 }
 
-void LobsterParser::print_stats() const
+LobsterParserPosition LobsterParser::get_position() const
 {
-    if (messages.empty())
+    LobsterParserPosition position{};
+    position.message_index = get_current_index();
+    if (source == Source::STREAM)
     {
-        std::cout << "No messages loaded" << std::endl;
-        return;
+        position.batch_start = stream_consumed;
+        position.batch_offset = batch_offset;
+        position.batch_line = batch_line;
+        position.streamed = 1;
+    }
+    return position;
+}
+
+bool LobsterParser::seek(const LobsterParserPosition &position)
+{
+    if (source == Source::CACHE || source == Source::MEMORY)
+    {
+        size_t count = source == Source::CACHE ? cache_count : messages.size();
+        if (position.message_index > count)
+            return false;
+        current_index = static_cast<size_t>(position.message_index);
+        return true;
+    }
+
+    if (position.streamed && position.batch_offset <= source_file.size() &&
+        position.message_index >= position.batch_start)
+    {
+        // Re-parse only the batch the position falls in
+        messages.clear();
+        stream_pos = source_file.data() + position.batch_offset;
+        source_file.rewind(static_cast<size_t>(position.batch_offset));
+        stream_consumed = static_cast<size_t>(position.batch_start);
+        line_number = static_cast<int>(position.batch_line);
+        refill_stream();
+        current_index = 0;
+    }
+    else
+    {
+        reset();
+    }
+
+    // Skip forward to the message itself, refilling as needed
+    while (get_current_index() < position.message_index)
+    {
+        if (current_index >= messages.size() && !refill_stream())
+            return false;
+        size_t skip = std::min(messages.size() - current_index,
+                               static_cast<size_t>(position.message_index - get_current_index()));
+        current_index += skip;
+    }
+    return true;
+}
+
+const LobsterSourceStamp &LobsterParser::get_source_stamp() const
+{
+    if (stamp_pending)
+    {
+        source_stamp = stamp_lobster_file(stream_filename);
+        stamp_pending = false;
     }
+    return source_stamp;
+}
 
-    // Count message types
-    int new_orders = 0, cancellations = 0, deletions = 0;
-    int executions_visible = 0, executions_hidden = 0, trading_halts = 0;
-    int buy_orders = 0, sell_orders = 0;
+void LobsterParser::compute_stats()
+{
+    stats = LobsterStats();
+    if (messages.empty())
+        return;
 
-    double min_price = messages[0].price;
-    double max_price = messages[0].price;
-    double start_time = messages[0].timestamp;
-    double end_time = messages[0].timestamp;
+    stats.total_messages = messages.size();
+    stats.min_price = messages[0].price;
+    stats.max_price = messages[0].price;
+    stats.start_time = messages[0].timestamp;
+    stats.end_time = messages[0].timestamp;
 
     for (const auto &msg : messages)
     {
-        switch (msg.type)
-        {
-        case LobsterMessageType::NEW_ORDER:
-            new_orders++;
-            break;
-        case LobsterMessageType::CANCELLATION:
-            cancellations++;
-            break;
-        case LobsterMessageType::DELETION:
-            deletions++;
-            break;
-        case LobsterMessageType::EXECUTION_VISIBLE:
-            executions_visible++;
-            break;
-        case LobsterMessageType::EXECUTION_HIDDEN:
-            executions_hidden++;
-            break;
-        case LobsterMessageType::TRADING_HALT:
-            trading_halts++;
-            break;
-        }
+        stats.type_counts[static_cast<int>(msg.type)]++;
 
         if (msg.direction == 1)
-            buy_orders++;
+            stats.buy_orders++;
         else
-            sell_orders++;
+            stats.sell_orders++;
+
+        stats.min_price = std::min(stats.min_price, msg.price);
+        stats.max_price = std::max(stats.max_price, msg.price);
+        stats.start_time = std::min(stats.start_time, msg.timestamp);
+        stats.end_time = std::max(stats.end_time, msg.timestamp);
+    }
+}
 
-        min_price = std::min(min_price, msg.price);
-        max_price = std::max(max_price, msg.price);
-        start_time = std::min(start_time, msg.timestamp);
-        end_time = std::max(end_time, msg.timestamp);
+void LobsterParser::print_stats() const
+{
+    if (source == Source::STREAM)
+    {
+        std::cout << "Statistics need the whole file; load it without streaming" << std::endl;
+        return;
     }
 
+    if (stats.total_messages == 0)
+    {
+        std::cout << "No messages loaded" << std::endl;
+        return;
+    }
+
+    auto count = [this](LobsterMessageType type)
+    { return stats.type_counts[static_cast<int>(type)]; };
+
     std::cout << "\n=== LOBSTER DATA STATISTICS ===" << std::endl;
-    std::cout << "Total Messages: " << messages.size() << std::endl;
+    std::cout << "Total Messages: " << stats.total_messages << std::endl;
     std::cout << "Time Range: " << std::fixed << std::setprecision(3)
-              << start_time << "s - " << end_time << "s ("
-              << (end_time - start_time) << "s duration)" << std::endl;
+              << stats.start_time << "s - " << stats.end_time << "s ("
+              << (stats.end_time - stats.start_time) << "s duration)" << std::endl;
     std::cout << "Price Range: $" << std::fixed << std::setprecision(2)
-              << min_price << " - $" << max_price << std::endl;
+              << price_to_double(stats.min_price) << " - $" << price_to_double(stats.max_price) << std::endl;
 
     std::cout << "\nMessage Types:" << std::endl;
-    std::cout << "  New Orders: " << new_orders << std::endl;
-    std::cout << "  Cancellations: " << cancellations << std::endl;
-    std::cout << "  Deletions: " << deletions << std::endl;
-    std::cout << "  Visible Executions: " << executions_visible << std::endl;
-    std::cout << "  Hidden Executions: " << executions_hidden << std::endl;
-    std::cout << "  Trading Halts: " << trading_halts << std::endl;
+    std::cout << "  New Orders: " << count(LobsterMessageType::NEW_ORDER) << std::endl;
+    std::cout << "  Cancellations: " << count(LobsterMessageType::CANCELLATION) << std::endl;
+    std::cout << "  Deletions: " << count(LobsterMessageType::DELETION) << std::endl;
+    std::cout << "  Visible Executions: " << count(LobsterMessageType::EXECUTION_VISIBLE) << std::endl;
+    std::cout << "  Hidden Executions: " << count(LobsterMessageType::EXECUTION_HIDDEN) << std::endl;
+    std::cout << "  Trading Halts: " << count(LobsterMessageType::TRADING_HALT) << std::endl;
 
     std::cout << "\nOrder Directions:" << std::endl;
-    std::cout << "  Buy Orders: " << buy_orders << std::endl;
-    std::cout << "  Sell Orders: " << sell_orders << std::endl;
+    std::cout << "  Buy Orders: " << stats.buy_orders << std::endl;
+    std::cout << "  Sell Orders: " << stats.sell_orders << std::endl;
     std::cout << "===============================" << std::endl;
-}
\ No newline at end of file
+}
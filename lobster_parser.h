@@ -1,7 +1,10 @@
 #ifndef LOBSTER_PARSER_H
 #define LOBSTER_PARSER_H
 
+#include "mapped_file.h"
 #include "order.h"
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -29,7 +32,7 @@ struct LobsterMessage
     LobsterMessageType type; // Type of the message
     int order_id;            // Unique identifier for the order
     int size;                // Number of shares in the order
-    double price;            // Price of the order (converted from 10000x format)
+    Price price;             // Price of the order in ticks (LOBSTER 10000x format)
     int direction;           // Order direction (1 = buy, -1 = sell)
 
     /**
@@ -38,11 +41,16 @@ struct LobsterMessage
      * @param type Type of the message
      * @param order_id Unique identifier for the order
      * @param size Number of shares
-     * @param price Price of the order
+     * @param price Price of the order in ticks
      * @param direction Order direction (1 = buy, -1 = sell)
      */
     LobsterMessage(double timestamp, LobsterMessageType type, int order_id,
-                   int size, double price, int direction);
+                   int size, Price price, int direction);
+
+    /**
+     * @brief Constructs an empty message, used for unfilled buffer slots.
+     */
+    LobsterMessage();
 
     /**
      * @brief Gets the order side (buy or sell) based on direction.
@@ -57,29 +65,208 @@ struct LobsterMessage
     std::string type_to_string() const;
 };
 
+/**
+ * @struct LobsterStats
+ * @brief Summary statistics of a message file, as stored in the binary cache header.
+ */
+struct LobsterStats
+{
+    uint64_t total_messages; // Number of messages
+    uint64_t type_counts[8]; // Messages per LobsterMessageType value
+    uint64_t buy_orders;     // Messages with direction 1
+    uint64_t sell_orders;    // Messages with direction -1
+    double start_time;       // Earliest timestamp
+    double end_time;         // Latest timestamp
+    Price min_price;         // Lowest price in ticks
+    Price max_price;         // Highest price in ticks
+};
+
+/**
+ * @struct LobsterSourceStamp
+ * @brief Identifies the exact CSV contents a binary cache was built from.
+ */
+struct LobsterSourceStamp
+{
+    uint64_t bytes;      // Size of the file
+    int64_t modified_ns; // Last write time, in the filesystem clock's nanoseconds
+    uint64_t hash;       // hash_lobster_source of the contents
+};
+
+/**
+ * @struct LobsterParserPosition
+ * @brief A point in the message sequence that a parser can be returned to with seek().
+ *
+ * For a stream it also records where the current read-ahead batch starts in the file,
+ * so seeking re-parses a single batch instead of everything before it.
+ */
+struct LobsterParserPosition
+{
+    uint64_t message_index; // Messages handed out before this point
+    uint64_t batch_start;   // Index of the first message of the enclosing stream batch
+    uint64_t batch_offset;  // File offset that batch was parsed from (streams only)
+    int64_t batch_line;     // Lines read before that batch (streams only)
+    uint8_t streamed;       // 1 if the batch fields are valid
+    uint8_t reserved[7];    // Zero
+};
+
+struct LobsterRecord;
+
 /**
  * @class LobsterParser
  * @brief Parses and manages LOBSTER data messages from a file.
+ *
+ * A file is either loaded whole into memory (load_file) or streamed (open_stream).
+ * In streaming mode the message vector is a fixed-size read-ahead buffer that is
+ * refilled from the mapped file as it drains, so memory use does not depend on the
+ * file size and messages are available as soon as the first batch is parsed.
+ *
+ * A binary cache (see lobster_cache.h) written after a parse is memory-mapped by later
+ * loads and its records are handed out directly, with no parsing at all.
  */
 class LobsterParser
 {
+public:
+    /** Default number of messages parsed per refill in streaming mode. */
+    static constexpr size_t DEFAULT_READ_AHEAD = 4096;
+
+    /** Smallest amount of text worth handing to its own parse thread. */
+    static constexpr size_t MIN_CHUNK_BYTES = size_t(1) << 20;
+
 private:
-    std::vector<LobsterMessage> messages; // Container for parsed messages
-    size_t current_index;                  // Current position in the message vector
+    /** A line that could not be parsed. */
+    struct ParseFailure
+    {
+        int line_number;     // Line number, relative to the start of its chunk
+        std::string error;   // Reason the line was rejected
+        std::string content; // The offending line
+    };
+
+    /** Messages parsed from one run of lines. */
+    struct ParsedChunk
+    {
+        std::vector<LobsterMessage> messages; // Messages, in file order
+        std::vector<ParseFailure> failures;   // Lines that could not be parsed
+        int lines = 0;                        // Lines consumed, including empty and failed ones
+    };
+
+    /** Where messages are read from. */
+    enum class Source
+    {
+        MEMORY, // Parsed up front into the message vector
+        STREAM, // Parsed batch by batch from source_file
+        CACHE   // Records mapped from a binary cache in source_file
+    };
+
+    Source source;
+    std::vector<LobsterMessage> messages; // Parsed messages (the read-ahead buffer when streaming)
+    size_t current_index;                  // Current position in the messages or records
+    LobsterStats stats;                    // Statistics of a loaded or cached file
+    // Stamp of the CSV the messages come from; a stream's is computed on first use,
+    // since hashing reads the whole file
+    mutable LobsterSourceStamp source_stamp;
+    mutable bool stamp_pending;  // True while a stream's stamp has not been computed
+    std::string stream_filename; // Path of the file being streamed
+
+    MappedFile source_file; // File being streamed, or cache being read
+
+    // Streaming state
+    const char *stream_pos; // First unparsed byte of source_file
+    size_t stream_consumed; // Messages handed out before the current buffer
+    size_t read_ahead;      // Messages parsed per refill
+    size_t batch_offset;    // File offset the current buffer was parsed from
+    int batch_line;         // Lines read before the current buffer
+
+    // Cache state
+    const LobsterRecord *cache_records;        // First record in source_file
+    size_t cache_count;                        // Number of records
+
+    int line_number;       // Lines read so far, for error reporting
+    int failed_lines;      // Lines that could not be parsed
+    unsigned parse_threads; // Threads used by load_file to parse CSV text
+
+    /**
+     * @brief Parses lines into a chunk until a limit or the end of the text.
+     *
+     * Touches no parser state, so chunks of one file can be parsed on several threads.
+     * @param p Start of the next line; advanced past every line consumed
+     * @param end End of the text
+     * @param max_messages Maximum number of messages to append
+     * @param chunk Receives the messages, failures and line count
+     * @return Number of messages appended
+     */
+    size_t parse_range(const char *&p, const char *end, size_t max_messages, ParsedChunk &chunk) const;
+
+    /**
+     * @brief Parses lines into the message vector until a limit or the end of the text.
+     * @param p Start of the next line; advanced past every line consumed
+     * @param end End of the text
+     * @param max_messages Maximum number of messages to append
+     * @return Number of messages appended
+     */
+    size_t parse_lines(const char *&p, const char *end, size_t max_messages);
 
     /**
-     * @brief Parses a single line of LOBSTER data into a LobsterMessage.
-     * @param line Input string containing the message data
+     * @brief Parses the whole text into the message vector on several threads.
+     *
+     * The text is split on line boundaries into one chunk per thread; chunks are
+     * appended and their failures reported in file order once all threads finish.
+     * @param begin Start of the text
+     * @param end End of the text
+     * @param threads Number of threads to use
+     * @return Number of messages appended
+     */
+    size_t parse_parallel(const char *begin, const char *end, unsigned threads);
+
+    /**
+     * @brief Prints parse failures with their line numbers in the file.
+     * @param failures Failures numbered relative to their chunk
+     * @param first_line Number of lines in the file before the chunk
+     */
+    void report_failures(const std::vector<ParseFailure> &failures, int first_line);
+
+    /**
+     * @brief Replaces the drained read-ahead buffer with the next batch from the stream.
+     * @return True if at least one more message was parsed
+     */
+    bool refill_stream();
+
+    /**
+     * @brief Maps a binary cache file as the message source.
+     * @param filename Path to the cache file
+     * @param csv_filename Path of the CSV the cache must have been built from, or empty to accept any
+     * @param csv Contents of that CSV (unused when csv_filename is empty)
+     * @return True if the file is a valid, matching cache; nothing changes otherwise
+     */
+    bool open_cache(const std::string &filename, const std::string &csv_filename, const MappedFile *csv);
+
+    /**
+     * @brief Computes statistics over the message vector.
+     */
+    void compute_stats();
+
+    /**
+     * @brief Parses a single line of LOBSTER data into a LobsterMessage, in place.
+     * @param begin First character of the line
+     * @param end One past the last character of the line (excluding the newline)
      * @return Parsed LobsterMessage object
+     * @throws std::runtime_error if the line is malformed
      */
-    LobsterMessage parse_line(const std::string &line);
+    LobsterMessage parse_line(const char *begin, const char *end) const;
 
     /**
-     * @brief Converts raw price (10000x format) to actual price.
+     * @brief Converts raw price (10000x format) to a tick price.
      * @param price_raw Raw price value
-     * @return Converted price as a double
+     * @return Converted price in ticks
      */
-    double convert_price(int price_raw);
+    Price convert_price(long long price_raw) const;
+
+    /**
+     * @brief Prints parse throughput for a completed load.
+     * @param bytes Number of bytes parsed
+     * @param message_count Number of messages produced
+     * @param seconds Wall-clock time spent parsing
+     */
+    static void print_throughput(size_t bytes, size_t message_count, double seconds);
 
 public:
     /**
@@ -89,10 +276,43 @@ public:
 
     /**
      * @brief Loads and parses messages from a LOBSTER data file.
-     * @param filename Path to the LOBSTER data file
+     *
+     * A binary cache file is mapped directly. For a CSV file, an up-to-date cache at
+     * lobster_cache_path(filename) is used instead of parsing when use_cache is set.
+     * @param filename Path to the LOBSTER data file (CSV or binary cache)
+     * @param use_cache If true, load the CSV's binary cache when one exists
      * @return True if file was successfully loaded and parsed, false otherwise
      */
-    bool load_file(const std::string &filename);
+    bool load_file(const std::string &filename, bool use_cache = true);
+
+    /**
+     * @brief Writes the loaded messages to a binary cache file.
+     * @param filename Path of the cache file to create
+     * @return True on success, false if nothing was parsed into memory or writing failed
+     */
+    bool write_cache(const std::string &filename) const;
+
+    /**
+     * @brief Sets how many threads load_file uses to parse CSV text.
+     *
+     * Small files use fewer threads, at most one per MIN_CHUNK_BYTES of text.
+     * @param threads Number of threads; 1 parses on the calling thread, 0 uses every core
+     */
+    void set_parse_threads(unsigned threads);
+
+    /**
+     * @brief Opens a LOBSTER data file for streaming instead of loading it whole.
+     * @param filename Path to the LOBSTER data file
+     * @param read_ahead Number of messages parsed ahead of the consumer
+     * @return True if the file was opened, false otherwise
+     */
+    bool open_stream(const std::string &filename, size_t read_ahead = DEFAULT_READ_AHEAD);
+
+    /**
+     * @brief Checks whether messages are being streamed rather than loaded.
+     * @return True in streaming mode
+     */
+    bool is_streaming() const;
 
     /**
      * @brief Resets the parser to the beginning of the message sequence.
@@ -101,9 +321,11 @@ public:
 
     /**
      * @brief Checks if there are more messages to process.
+     *
+     * In streaming mode this parses the next batch once the buffer is drained.
      * @return True if there are unprocessed messages, false otherwise
      */
-    bool has_next_message() const;
+    bool has_next_message();
 
     /**
      * @brief Retrieves the next message in the sequence.
@@ -111,9 +333,16 @@ public:
      */
     LobsterMessage get_next_message();
 
+    /**
+     * @brief Returns the next message without consuming it.
+     * @return The message the next get_next_message call will return
+     * @throws std::runtime_error if there are no more messages
+     */
+    LobsterMessage peek_next_message();
+
     /**
      * @brief Gets the total number of messages loaded.
-     * @return Total number of messages
+     * @return Total number of messages (parsed so far, in streaming mode)
      */
     size_t get_total_messages() const;
 
@@ -123,6 +352,31 @@ public:
      */
     size_t get_current_index() const;
 
+    /**
+     * @brief Gets the current position, for returning to it later with seek().
+     * @return The position of the next message
+     */
+    LobsterParserPosition get_position() const;
+
+    /**
+     * @brief Returns to a position taken from this file by get_position().
+     *
+     * Loaded and cached files jump directly. A stream re-parses the batch holding the
+     * position, or every message before it if the position was not taken while streaming.
+     * @param position The position to return to
+     * @return False if the file has fewer messages than the position
+     */
+    bool seek(const LobsterParserPosition &position);
+
+    /**
+     * @brief Gets the stamp of the CSV file the messages come from, to tell files apart.
+     *
+     * A binary cache reports the stamp of the CSV it was built from, so every form of
+     * one file gives the same stamp. A stream's file is hashed on the first call.
+     * @return The file's size, last write time and content hash
+     */
+    const LobsterSourceStamp &get_source_stamp() const;
+
     /**
      * @brief Prints statistics about the parsed messages.
      */
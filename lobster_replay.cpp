@@ -1,36 +1,137 @@
 #include "lobster_replay.h"
+#include "book_snapshot.h"
+#include "lobster_cache.h"
+#include "lobster_orderbook.h"
+#include "spsc_ring.h"
+#include <cstring>
+#include <fstream>
 #include <iostream>
 #include <iomanip>
+#include <sstream>
 #include <thread>
 #include <chrono>
+#include <algorithm>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+    // Upper bound on the hashed index pre-size; a replay rarely has this many live orders
+    constexpr size_t MAX_PRESIZED_ORDERS = size_t(1) << 20;
+
+    // Pre-size for a busy book when streaming; the message count is unknown up front
+    constexpr size_t STREAM_PRESIZED_ORDERS = size_t(1) << 16;
+
+    // Messages between checks of the progress clock
+    constexpr int PROGRESS_CHECK_MASK = 4095;
+
+    const char *const MESSAGE_TYPE_NAMES[8] = {"", "New Order", "Cancellation", "Deletion",
+                                               "Execution (Visible)", "Execution (Hidden)", "",
+                                               "Trading Halt"};
+
+    // Peak resident set size of the process in bytes, 0 if unknown
+    size_t peak_rss_bytes()
+    {
+#if defined(__unix__) || defined(__APPLE__)
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0)
+            return 0;
+#ifdef __APPLE__
+        return static_cast<size_t>(usage.ru_maxrss);
+#else
+        return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#else
+        return 0;
+#endif
+    }
+}
 
 LobsterReplayEngine::LobsterReplayEngine()
-    : processed_messages(0), successful_operations(0),
-      failed_operations(0), trades_executed(0) {}
+    : mode(ReplayMode::MATCHING), processed_messages(0),
+      successful_operations(0), failed_operations(0), trades_executed(0),
+      matched_trades(0), pipelined(false), producer_stall_seconds(0), consumer_stall_seconds(0),
+      replay_seconds(0), replay_cycles(0), parse_cycles(0), match_cycles(0),
+      type_messages{}, type_cycles{}, checkpoint_interval(0), base_checkpoint_interval(0),
+      checkpoint_bytes(0), next_checkpoint(SIZE_MAX), last_timestamp(0), batch_size(DEFAULT_BATCH_SIZE),
+      batched_messages(0), revealed_levels(0), validating(false), seeded_updates(0), unknown_id_messages(0),
+      message_latency({"", "new_order", "cancellation", "deletion", "execution_visible",
+                       "execution_hidden", "", "trading_halt"}) {}
 
-bool LobsterReplayEngine::load_data(const std::string &filename)
+bool LobsterReplayEngine::load_data(const std::string &filename, bool streaming, unsigned parse_threads)
 {
+    // Checkpoints belong to the previous file
+    clear_checkpoints();
     reset();
-    bool success = parser.load_file(filename);
+    parser.set_parse_threads(parse_threads);
+    bool success = streaming ? parser.open_stream(filename) : parser.load_file(filename);
     if (success)
     {
-        parser.print_stats();
+        presize_indexes();
+        if (!parser.is_streaming())
+            parser.print_stats();
     }
     return success;
 }
 
+void LobsterReplayEngine::presize_indexes()
+{
+    // The stream's length is unknown, so start from a fixed size
+    if (parser.is_streaming())
+    {
+        lobster_to_internal_id.configure(IdIndexMode::HASHED, STREAM_PRESIZED_ORDERS);
+        lob.configure_order_index(IdIndexMode::HASHED, STREAM_PRESIZED_ORDERS);
+        return;
+    }
+
+    // Every message creates at most one order, so the message count bounds the live orders
+    size_t total = parser.get_total_messages();
+    size_t live = std::min(total, MAX_PRESIZED_ORDERS);
+
+    lobster_to_internal_id.configure(IdIndexMode::HASHED, live);
+    lob.configure_order_index(IdIndexMode::HASHED, live);
+}
+
 void LobsterReplayEngine::reset()
+{
+    clear_state();
+    presize_indexes();
+}
+
+void LobsterReplayEngine::clear_state()
 {
     parser.reset();
     lobster_to_internal_id.clear();
-    internal_to_lobster_id.clear();
     processed_messages = 0;
     successful_operations = 0;
     failed_operations = 0;
     trades_executed = 0;
+    matched_trades = 0;
+    pipelined = false;
+    producer_stall_seconds = 0;
+    consumer_stall_seconds = 0;
+    replay_seconds = 0;
+    replay_cycles = 0;
+    parse_cycles = 0;
+    match_cycles = 0;
+    std::fill(std::begin(type_messages), std::end(type_messages), 0);
+    std::fill(std::begin(type_cycles), std::end(type_cycles), 0);
+    batched_messages = 0;
+    seeded_bids.clear();
+    seeded_asks.clear();
+    revealed_levels = 0;
+    seeded_updates = 0;
+    unknown_id_messages = 0;
+    message_latency.clear();
+    last_timestamp = 0;
+    update_next_checkpoint();
 
     // Reset LOB (create new instance)
-    lob = LimitOrderBook();
+    lob = ReplayOrderBook();
+    lob.get_event_sink().attach_feed(market_data.get());
 }
 
 void LobsterReplayEngine::print_message_info(const LobsterMessage &msg)
@@ -40,7 +141,7 @@ void LobsterReplayEngine::print_message_info(const LobsterMessage &msg)
               << msg.type_to_string() << " - "
               << "ID:" << msg.order_id << " "
               << "Size:" << msg.size << " "
-              << "Price:$" << std::setprecision(2) << msg.price << " "
+              << "Price:$" << std::setprecision(2) << price_to_double(msg.price) << " "
               << "Side:" << (msg.direction == 1 ? "BUY" : "SELL") << std::endl;
 }
 
@@ -48,9 +149,10 @@ void LobsterReplayEngine::process_new_order(const LobsterMessage &msg)
 {
     try
     {
-        int internal_id = lob.add_limit_order(msg.get_order_side(), msg.price, msg.size);
-        lobster_to_internal_id[msg.order_id] = internal_id;
-        internal_to_lobster_id[internal_id] = msg.order_id;
+        int internal_id = mode == ReplayMode::RECONSTRUCTION
+                              ? lob.insert_order(msg.get_order_side(), msg.price, msg.size)
+                              : lob.add_limit_order(msg.get_order_side(), msg.price, msg.size);
+        lobster_to_internal_id.insert(msg.order_id, internal_id);
         successful_operations++;
     }
     catch (const std::exception &e)
@@ -62,76 +164,136 @@ void LobsterReplayEngine::process_new_order(const LobsterMessage &msg)
 
 void LobsterReplayEngine::process_cancellation(const LobsterMessage &msg)
 {
-    // Note: LOBSTER cancellations are partial deletions
-    // For simplicity, we'll treat them as full cancellations
-    // In a full implementation, you'd need to track partial quantities
+    // LOBSTER cancellations are partial: the order keeps its place with less quantity
+    const int *it = lobster_to_internal_id.find(msg.order_id);
+    if (!it && apply_to_seeded_level(msg))
+        return;
+    int internal_id = it ? *it : 0;
+    finish_cancellation(msg, it != nullptr, internal_id, it ? lob.reduce_order(internal_id, msg.size) : -1);
+}
 
-    auto it = lobster_to_internal_id.find(msg.order_id);
-    if (it != lobster_to_internal_id.end())
+void LobsterReplayEngine::process_deletion(const LobsterMessage &msg)
+{
+    const int *it = lobster_to_internal_id.find(msg.order_id);
+    if (!it && apply_to_seeded_level(msg))
+        return;
+    int internal_id = it ? *it : 0;
+    finish_deletion(msg, it != nullptr, internal_id, it && lob.cancel_order(internal_id));
+}
+
+void LobsterReplayEngine::process_execution(const LobsterMessage &msg)
+{
+    // Executions are trades that already happened at the exchange; fill the named order directly
+    const int *it = lobster_to_internal_id.find(msg.order_id);
+    if (!it && msg.type == LobsterMessageType::EXECUTION_VISIBLE && apply_to_seeded_level(msg))
     {
-        int internal_id = it->second;
-        if (lob.cancel_order(internal_id))
-        {
-            lobster_to_internal_id.erase(it);
-            internal_to_lobster_id.erase(internal_id);
-            successful_operations++;
-        }
-        else
-        {
-            std::cerr << "Warning: Could not cancel order " << msg.order_id
-                      << " (internal ID: " << internal_id << ")" << std::endl;
-            failed_operations++;
-        }
+        trades_executed++;
+        return;
     }
-    else
+    int internal_id = it ? *it : 0;
+    finish_execution(msg, it != nullptr, internal_id, it ? lob.fill_order(internal_id, msg.size) : -1);
+}
+
+bool LobsterReplayEngine::apply_to_seeded_level(const LobsterMessage &msg)
+{
+    std::unordered_map<Price, int> &seeded = msg.direction == 1 ? seeded_bids : seeded_asks;
+    auto it = seeded.find(msg.price);
+    if (it == seeded.end())
+        return false;
+
+    int remaining = msg.type == LobsterMessageType::EXECUTION_VISIBLE ? lob.fill_order(it->second, msg.size)
+                                                                       : lob.reduce_order(it->second, msg.size);
+    if (remaining <= 0)
+        seeded.erase(it);
+    if (remaining < 0)
+        return false;
+
+    seeded_updates++;
+    successful_operations++;
+    return true;
+}
+
+void LobsterReplayEngine::report_unknown_order(const char *operation, const LobsterMessage &msg)
+{
+    failed_operations++;
+    if (validating)
     {
-        std::cerr << "Warning: Cancellation for unknown order ID " << msg.order_id << std::endl;
-        failed_operations++;
+        unknown_id_messages++;
+        return;
     }
+    std::cerr << "Warning: " << operation << " for unknown order ID " << msg.order_id << std::endl;
 }
 
-void LobsterReplayEngine::process_deletion(const LobsterMessage &msg)
+void LobsterReplayEngine::forget_order(int lobster_id, int internal_id)
+{
+    // Within a block the LOBSTER id may already name a newer order; leave that mapping alone
+    const int *it = lobster_to_internal_id.find(lobster_id);
+    if (it && *it == internal_id)
+        lobster_to_internal_id.erase(lobster_id);
+}
+
+void LobsterReplayEngine::finish_cancellation(const LobsterMessage &msg, bool known, int internal_id, int remaining)
 {
-    auto it = lobster_to_internal_id.find(msg.order_id);
-    if (it != lobster_to_internal_id.end())
+    if (!known)
+        report_unknown_order("Cancellation", msg);
+    else if (remaining < 0)
     {
-        int internal_id = it->second;
-        if (lob.cancel_order(internal_id))
-        {
-            lobster_to_internal_id.erase(it);
-            internal_to_lobster_id.erase(internal_id);
-            successful_operations++;
-        }
-        else
-        {
-            std::cerr << "Warning: Could not delete order " << msg.order_id
-                      << " (internal ID: " << internal_id << ")" << std::endl;
-            failed_operations++;
-        }
+        std::cerr << "Warning: Could not cancel order " << msg.order_id
+                  << " (internal ID: " << internal_id << ")" << std::endl;
+        failed_operations++;
     }
     else
     {
-        std::cerr << "Warning: Deletion for unknown order ID " << msg.order_id << std::endl;
+        if (remaining == 0)
+            forget_order(msg.order_id, internal_id);
+        successful_operations++;
+    }
+}
+
+void LobsterReplayEngine::finish_deletion(const LobsterMessage &msg, bool known, int internal_id, bool deleted)
+{
+    if (!known)
+        report_unknown_order("Deletion", msg);
+    else if (!deleted)
+    {
+        std::cerr << "Warning: Could not delete order " << msg.order_id
+                  << " (internal ID: " << internal_id << ")" << std::endl;
         failed_operations++;
     }
+    else
+    {
+        forget_order(msg.order_id, internal_id);
+        successful_operations++;
+    }
 }
 
-void LobsterReplayEngine::process_execution(const LobsterMessage &msg)
+void LobsterReplayEngine::finish_execution(const LobsterMessage &msg, bool known, int internal_id, int remaining)
 {
-    // Executions in LOBSTER data represent trades that already happened
-    // We don't need to execute them again in our LOB, just count them
     trades_executed++;
-    successful_operations++;
 
-    // Remove the executed order from our tracking
-    auto it = lobster_to_internal_id.find(msg.order_id);
-    if (it != lobster_to_internal_id.end())
+    if (!known)
+    {
+        // Hidden executions normally hit orders that never appeared in the visible book
+        if (msg.type == LobsterMessageType::EXECUTION_HIDDEN)
+        {
+            successful_operations++;
+            return;
+        }
+        report_unknown_order("Execution", msg);
+        return;
+    }
+
+    if (remaining < 0)
     {
-        int internal_id = it->second;
-        // The order should already be removed/reduced by the matching engine
-        lobster_to_internal_id.erase(it);
-        internal_to_lobster_id.erase(internal_id);
+        std::cerr << "Warning: Could not execute order " << msg.order_id
+                  << " (internal ID: " << internal_id << ")" << std::endl;
+        failed_operations++;
+        return;
     }
+
+    if (remaining == 0)
+        forget_order(msg.order_id, internal_id);
+    successful_operations++;
 }
 
 void LobsterReplayEngine::process_trading_halt(const LobsterMessage &msg)
@@ -141,26 +303,11 @@ void LobsterReplayEngine::process_trading_halt(const LobsterMessage &msg)
     successful_operations++;
 }
 
-void LobsterReplayEngine::replay_all(bool verbose, bool step_by_step)
+void LobsterReplayEngine::process_message(const LobsterMessage &msg, bool verbose)
 {
-    std::cout << "\nStarting LOBSTER data replay..." << std::endl;
-    std::cout << "Total messages to process: " << parser.get_total_messages() << std::endl;
-
-    if (step_by_step)
-    {
-        std::cout << "Step-by-step mode: Press Enter after each message..." << std::endl;
-    }
-
-    while (parser.has_next_message())
+    uint64_t match_start = read_cycles();
     {
-        LobsterMessage msg = parser.get_next_message();
-        processed_messages++;
-
-        if (verbose)
-        {
-            print_message_info(msg);
-        }
-
+        LOB_MEASURE_LATENCY(message_latency, msg.type);
         switch (msg.type)
         {
         case LobsterMessageType::NEW_ORDER:
@@ -180,6 +327,173 @@ void LobsterReplayEngine::replay_all(bool verbose, bool step_by_step)
             process_trading_halt(msg);
             break;
         }
+    }
+    uint64_t match_time = read_cycles() - match_start;
+    match_cycles += match_time;
+    size_t type = static_cast<size_t>(msg.type) & 7;
+    type_messages[type]++;
+    type_cycles[type] += match_time;
+
+    collect_trades(verbose);
+
+    if (market_data)
+        market_data->publish(static_cast<uint64_t>(processed_messages), msg.timestamp);
+    last_timestamp = msg.timestamp;
+}
+
+void LobsterReplayEngine::collect_trades(bool verbose)
+{
+    // Trades only appear when a historical add crosses our reconstructed book
+    TradeRecorder &recorder = lob.get_event_sink();
+    if (!recorder.get_trades().empty())
+    {
+        matched_trades += static_cast<int>(recorder.get_trades().size() + recorder.get_dropped());
+        if (verbose)
+        {
+            for (const TradeEvent &trade : recorder.get_trades())
+                print_trade(trade);
+        }
+        recorder.clear();
+    }
+}
+
+void LobsterReplayEngine::process_block(const LobsterMessage *messages, size_t count)
+{
+    uint64_t match_start = read_cycles();
+    BookCommandType add_type = mode == ReplayMode::RECONSTRUCTION ? BookCommandType::INSERT
+                                                                  : BookCommandType::LIMIT;
+
+    for (size_t start = 0, end = 0; start < count; start = end)
+    {
+        block_commands.clear();
+        block_entries.clear();
+
+        // Translate messages up front. New orders get the ids the book will hand out, so
+        // later messages can already refer to them. A message whose order an earlier
+        // command may have finished starts the next segment, since whether its LOBSTER
+        // id is still known depends on that command's result
+        int next_internal_id = lob.get_next_order_id();
+        for (; end < count; end++)
+        {
+            const LobsterMessage &msg = messages[end];
+            BlockEntry entry{-1, 0};
+            BookCommand command{add_type, msg.get_order_side(), 0, msg.size, msg.price};
+
+            if (msg.type == LobsterMessageType::NEW_ORDER)
+            {
+                entry.internal_id = next_internal_id++;
+                lobster_to_internal_id.insert(msg.order_id, entry.internal_id);
+            }
+            else
+            {
+                const int *it = msg.type == LobsterMessageType::TRADING_HALT
+                                    ? nullptr
+                                    : lobster_to_internal_id.find(msg.order_id);
+                if (!it)
+                {
+                    block_entries.push_back(entry);
+                    continue;
+                }
+                if (block_targets.find(msg.order_id))
+                    break;
+                block_targets.insert(msg.order_id, 0);
+
+                entry.internal_id = *it;
+                command.order_id = *it;
+                command.type = msg.type == LobsterMessageType::CANCELLATION ? BookCommandType::REDUCE
+                               : msg.type == LobsterMessageType::DELETION   ? BookCommandType::CANCEL
+                                                                            : BookCommandType::FILL;
+            }
+
+            entry.command = static_cast<int>(block_commands.size());
+            block_commands.push_back(command);
+            block_entries.push_back(entry);
+        }
+
+        block_results.resize(block_commands.size());
+        lob.process_batch(block_commands.data(), block_commands.size(), block_results.data());
+
+        // Account for the results in message order, exactly as one call per message would
+        for (size_t i = start; i < end; i++)
+        {
+            const LobsterMessage &msg = messages[i];
+            const BlockEntry &entry = block_entries[i - start];
+            bool known = entry.command >= 0;
+            int result = known ? block_results[static_cast<size_t>(entry.command)] : -1;
+
+            switch (msg.type)
+            {
+            case LobsterMessageType::NEW_ORDER:
+                successful_operations++;
+                break;
+            case LobsterMessageType::CANCELLATION:
+                finish_cancellation(msg, known, entry.internal_id, result);
+                block_targets.erase(msg.order_id);
+                break;
+            case LobsterMessageType::DELETION:
+                finish_deletion(msg, known, entry.internal_id, result == 1);
+                block_targets.erase(msg.order_id);
+                break;
+            case LobsterMessageType::EXECUTION_VISIBLE:
+            case LobsterMessageType::EXECUTION_HIDDEN:
+                finish_execution(msg, known, entry.internal_id, result);
+                block_targets.erase(msg.order_id);
+                break;
+            case LobsterMessageType::TRADING_HALT:
+                process_trading_halt(msg);
+                break;
+            }
+        }
+    }
+
+    processed_messages += static_cast<int>(count);
+    batched_messages += count;
+    if (count > 0)
+        last_timestamp = messages[count - 1].timestamp;
+    collect_trades(false);
+    match_cycles += read_cycles() - match_start;
+}
+
+void LobsterReplayEngine::replay_all(bool verbose, bool step_by_step)
+{
+    std::cout << "\nStarting LOBSTER data replay..." << std::endl;
+    if (parser.is_streaming())
+        std::cout << "Streaming messages from file..." << std::endl;
+    else
+        std::cout << "Total messages to process: " << parser.get_total_messages() << std::endl;
+
+    if (step_by_step)
+    {
+        std::cout << "Step-by-step mode: Press Enter after each message..." << std::endl;
+    }
+
+    auto wall_start = std::chrono::steady_clock::now();
+    uint64_t loop_start = read_cycles();
+    next_progress_report = wall_start + PROGRESS_INTERVAL;
+
+    // Per-message output needs one book call per message; otherwise apply whole blocks
+    if (!verbose && !step_by_step && use_blocks())
+    {
+        while (size_t n = fetch_block())
+        {
+            process_block(block_messages.data(), n);
+            record_checkpoint_if_due();
+            report_progress(static_cast<int>(n));
+        }
+    }
+
+    LobsterMessage msg;
+    while (fetch_message(msg))
+    {
+        processed_messages++;
+
+        if (verbose)
+        {
+            print_message_info(msg);
+        }
+
+        process_message(msg, verbose);
+        record_checkpoint_if_due();
 
         if (step_by_step)
         {
@@ -189,25 +503,363 @@ void LobsterReplayEngine::replay_all(bool verbose, bool step_by_step)
         }
 
         // Progress indicator for large files
-        if (!verbose && processed_messages % 1000 == 0)
+        if (!verbose)
         {
-            std::cout << "Processed " << processed_messages << " messages..." << std::endl;
+            report_progress();
         }
     }
 
+    replay_cycles += read_cycles() - loop_start;
+    replay_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+
     std::cout << "\nReplay completed!" << std::endl;
     print_statistics();
     print_current_book();
 }
 
+void LobsterReplayEngine::replay_pipelined(bool verbose, size_t ring_capacity)
+{
+    using Clock = std::chrono::steady_clock;
+
+    std::cout << "\nStarting pipelined LOBSTER data replay..." << std::endl;
+    SpscRing<LobsterMessage> ring(ring_capacity);
+    std::cout << "Decoder and matcher threads joined by a " << ring.capacity()
+              << "-message ring" << std::endl;
+
+    pipelined = true;
+    producer_stall_seconds = 0;
+    consumer_stall_seconds = 0;
+
+    // The parser belongs to the producer until it closes the ring
+    std::thread producer([this, &ring]
+                         {
+        LobsterMessage msg;
+        while (fetch_message(msg))
+        {
+            if (ring.try_push(msg))
+                continue;
+
+            // Back-pressure: the matcher is behind, wait for a free slot
+            auto stall_start = Clock::now();
+            while (!ring.try_push(msg))
+                std::this_thread::yield();
+            producer_stall_seconds += std::chrono::duration<double>(Clock::now() - stall_start).count();
+        }
+        ring.close(); });
+
+    // Pops the next message, waiting while the ring is empty; false once it is drained
+    auto next_message = [this, &ring](LobsterMessage &msg)
+    {
+        if (ring.try_pop(msg))
+            return true;
+
+        auto stall_start = Clock::now();
+        bool popped;
+        while (!(popped = ring.try_pop(msg)))
+        {
+            // Everything is pushed before the close, so an empty ring after it is the end
+            if (ring.is_closed())
+            {
+                popped = ring.try_pop(msg);
+                break;
+            }
+            std::this_thread::yield();
+        }
+        consumer_stall_seconds += std::chrono::duration<double>(Clock::now() - stall_start).count();
+        return popped;
+    };
+
+    auto wall_start = Clock::now();
+    uint64_t loop_start = read_cycles();
+    next_progress_report = wall_start + PROGRESS_INTERVAL;
+
+    LobsterMessage msg;
+    while (next_message(msg))
+    {
+        processed_messages++;
+
+        if (verbose)
+        {
+            print_message_info(msg);
+        }
+
+        process_message(msg, verbose);
+
+        // Progress indicator for large files
+        if (!verbose)
+        {
+            report_progress();
+        }
+    }
+
+    producer.join();
+    replay_cycles += read_cycles() - loop_start;
+    replay_seconds += std::chrono::duration<double>(Clock::now() - wall_start).count();
+
+    std::cout << "\nReplay completed!" << std::endl;
+    print_statistics();
+    print_current_book();
+}
+
+bool LobsterReplayEngine::fetch_message(LobsterMessage &msg)
+{
+    uint64_t start = read_cycles();
+    bool available = parser.has_next_message();
+    if (available)
+        msg = parser.get_next_message();
+    parse_cycles += read_cycles() - start;
+    return available;
+}
+
+size_t LobsterReplayEngine::fetch_block()
+{
+    uint64_t start = read_cycles();
+    block_messages.resize(batch_size);
+    size_t count = 0;
+    while (count < batch_size && parser.has_next_message())
+        block_messages[count++] = parser.get_next_message();
+    parse_cycles += read_cycles() - start;
+    return count;
+}
+
+bool LobsterReplayEngine::use_blocks() const
+{
+    // Level deltas are coalesced per message, so a feed needs message-by-message processing
+    // Seeded levels absorb unknown-id messages one at a time, in order with the rest
+    return batch_size > 1 && !market_data && seeded_bids.empty() && seeded_asks.empty();
+}
+
+void LobsterReplayEngine::report_progress(int messages)
+{
+    // Consult the clock only when a multiple of PROGRESS_CHECK_MASK + 1 messages was crossed
+    if (((processed_messages - messages) | PROGRESS_CHECK_MASK) == (processed_messages | PROGRESS_CHECK_MASK))
+        return;
+
+    auto now = std::chrono::steady_clock::now();
+    if (now < next_progress_report)
+        return;
+
+    next_progress_report = now + PROGRESS_INTERVAL;
+    std::cout << "Processed " << processed_messages << " messages..." << std::endl;
+}
+
+void LobsterReplayEngine::seed_from_snapshot(const LobsterMessage &first, const DepthLevel *snapshot, size_t levels)
+{
+    bool split_add = first.type == LobsterMessageType::NEW_ORDER;
+    auto seed = [&](OrderSide side, Price price, int size)
+    {
+        if (split_add && first.get_order_side() == side && first.price == price)
+            size -= first.size;
+        if (size <= 0)
+            return;
+        int internal_id = lob.add_limit_order(side, price, size);
+        (side == OrderSide::BUY ? seeded_bids : seeded_asks)[price] = internal_id;
+    };
+
+    // Seeded orders have no LOBSTER id; messages for them are applied by price instead
+    for (size_t i = 0; i < levels; i++)
+    {
+        seed(OrderSide::SELL, snapshot[i].ask_price, snapshot[i].ask_size);
+        seed(OrderSide::BUY, snapshot[i].bid_price, snapshot[i].bid_size);
+    }
+
+    if (split_add)
+        process_message(first, false);
+}
+
+bool LobsterReplayEngine::seed_revealed_levels(const DepthLevel *expected, const DepthLevel *actual, size_t levels)
+{
+    bool seeded_any = false;
+    auto reveal = [&](OrderSide side, Price price, int size)
+    {
+        std::unordered_map<Price, int> &seeded = side == OrderSide::BUY ? seeded_bids : seeded_asks;
+        if (size <= 0 || seeded.count(price))
+            return;
+
+        int replayed = 0;
+        for (size_t i = 0; i < levels; i++)
+        {
+            if (side == OrderSide::BUY ? actual[i].bid_price == price : actual[i].ask_price == price)
+                replayed = side == OrderSide::BUY ? actual[i].bid_size : actual[i].ask_size;
+        }
+
+        // Whatever the replay already holds came from the file; only the rest predates it
+        int internal_id = -1;
+        if (size > replayed)
+        {
+            internal_id = lob.add_limit_order(side, price, size - replayed);
+            revealed_levels++;
+            seeded_any = true;
+        }
+        seeded[price] = internal_id;
+    };
+
+    for (size_t i = 0; i < levels; i++)
+    {
+        reveal(OrderSide::SELL, expected[i].ask_price, expected[i].ask_size);
+        reveal(OrderSide::BUY, expected[i].bid_price, expected[i].bid_size);
+    }
+    return seeded_any;
+}
+
+ValidationReport LobsterReplayEngine::replay_validate(const std::string &orderbook_filename)
+{
+    ValidationReport report{};
+    LobsterOrderbookReader orderbook;
+    if (!orderbook.open(orderbook_filename))
+    {
+        std::cerr << "Error: Could not read orderbook file " << orderbook_filename << std::endl;
+        return report;
+    }
+
+    report.levels = orderbook.get_levels();
+    std::vector<DepthLevel> expected(report.levels);
+    std::vector<DepthLevel> actual(report.levels);
+
+    reset();
+    validating = true;
+    std::cout << "\nValidating replay against " << orderbook_filename << " ("
+              << report.levels << " levels per side)..." << std::endl;
+
+    auto wall_start = std::chrono::steady_clock::now();
+    uint64_t loop_start = read_cycles();
+    next_progress_report = wall_start + PROGRESS_INTERVAL;
+
+    try
+    {
+        LobsterMessage msg;
+        while (fetch_message(msg))
+        {
+            if (!orderbook.next_row(expected.data()))
+            {
+                std::cerr << "Warning: Orderbook file ended before message " << processed_messages + 1 << std::endl;
+                break;
+            }
+            processed_messages++;
+
+            if (processed_messages == 1)
+            {
+                seed_from_snapshot(msg, expected.data(), report.levels);
+                continue;
+            }
+
+            process_message(msg, false);
+            lob.get_depth(actual.data(), report.levels);
+            if (seed_revealed_levels(expected.data(), actual.data(), report.levels))
+                lob.get_depth(actual.data(), report.levels);
+            report.compared++;
+
+            if (!depth_equal(expected.data(), actual.data(), report.levels))
+            {
+                if (report.diverged == 0)
+                {
+                    size_t level = 0;
+                    while (depth_equal(&expected[level], &actual[level], 1))
+                        level++;
+                    report.first_divergence = static_cast<uint64_t>(processed_messages);
+                    report.first_timestamp = msg.timestamp;
+                    report.first_level = level + 1;
+                    report.expected = expected[level];
+                    report.actual = actual[level];
+                }
+                report.diverged++;
+            }
+
+            report_progress();
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: Orderbook file line " << orderbook.get_line_number() << ": " << e.what() << std::endl;
+    }
+
+    validating = false;
+    report.revealed_levels = revealed_levels;
+    report.seeded_updates = seeded_updates;
+    report.unknown_ids = unknown_id_messages;
+    replay_cycles += read_cycles() - loop_start;
+    replay_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+
+    auto print_level = [](const char *label, const DepthLevel &level)
+    {
+        std::cout << "  " << label << std::fixed << std::setprecision(4)
+                  << "ask " << price_to_double(level.ask_price) << " x " << level.ask_size
+                  << ", bid " << price_to_double(level.bid_price) << " x " << level.bid_size << std::endl;
+    };
+
+    std::cout << "\n=== VALIDATION ===" << std::endl;
+    std::cout << "Messages Compared: " << report.compared << std::endl;
+    std::cout << "Diverged: " << report.diverged;
+    if (report.compared > 0)
+    {
+        std::cout << " (" << std::fixed << std::setprecision(2)
+                  << 100.0 * static_cast<double>(report.diverged) / static_cast<double>(report.compared) << "%)";
+    }
+    std::cout << std::endl;
+    if (report.diverged > 0)
+    {
+        std::cout << "First Divergence: message " << report.first_divergence << " at " << std::fixed
+                  << std::setprecision(6) << report.first_timestamp << "s, level " << report.first_level << std::endl;
+        print_level("expected: ", report.expected);
+        print_level("replayed: ", report.actual);
+    }
+    std::cout << "Levels Seeded After First Row: " << report.revealed_levels << std::endl;
+    std::cout << "Seeded Level Updates: " << report.seeded_updates << std::endl;
+    std::cout << "Unknown Order IDs: " << report.unknown_ids << std::endl;
+    std::cout << "Validation Time: " << std::fixed << std::setprecision(3) << replay_seconds << "s" << std::endl;
+    std::cout << "==================" << std::endl;
+
+    return report;
+}
+
+int LobsterReplayEngine::replay_silent()
+{
+    auto wall_start = std::chrono::steady_clock::now();
+    uint64_t loop_start = read_cycles();
+
+    int count = 0;
+    if (use_blocks())
+    {
+        while (size_t n = fetch_block())
+        {
+            process_block(block_messages.data(), n);
+            record_checkpoint_if_due();
+            count += static_cast<int>(n);
+        }
+    }
+    else
+    {
+        LobsterMessage msg;
+        while (fetch_message(msg))
+        {
+            process(msg);
+            record_checkpoint_if_due();
+            count++;
+        }
+    }
+
+    replay_cycles += read_cycles() - loop_start;
+    replay_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+    return count;
+}
+
+void LobsterReplayEngine::process(const LobsterMessage &msg)
+{
+    processed_messages++;
+    process_message(msg, false);
+}
+
 void LobsterReplayEngine::replay_n_messages(int n, bool verbose)
 {
     std::cout << "\nReplaying next " << n << " messages..." << std::endl;
 
+    auto wall_start = std::chrono::steady_clock::now();
+    uint64_t loop_start = read_cycles();
+
     int count = 0;
-    while (parser.has_next_message() && count < n)
+    LobsterMessage msg;
+    while (count < n && fetch_message(msg))
     {
-        LobsterMessage msg = parser.get_next_message();
         processed_messages++;
         count++;
 
@@ -216,39 +868,324 @@ void LobsterReplayEngine::replay_n_messages(int n, bool verbose)
             print_message_info(msg);
         }
 
-        switch (msg.type)
-        {
-        case LobsterMessageType::NEW_ORDER:
-            process_new_order(msg);
-            break;
-        case LobsterMessageType::CANCELLATION:
-            process_cancellation(msg);
-            break;
-        case LobsterMessageType::DELETION:
-            process_deletion(msg);
-            break;
-        case LobsterMessageType::EXECUTION_VISIBLE:
-        case LobsterMessageType::EXECUTION_HIDDEN:
-            process_execution(msg);
-            break;
-        case LobsterMessageType::TRADING_HALT:
-            process_trading_halt(msg);
-            break;
-        }
+        process_message(msg, verbose);
+        record_checkpoint_if_due();
     }
 
+    replay_cycles += read_cycles() - loop_start;
+    replay_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+
     std::cout << "Processed " << count << " messages." << std::endl;
     print_current_book();
 }
 
+bool LobsterReplayEngine::save_state(std::ostream &out) const
+{
+    ReplaySnapshotHeader header{};
+    std::memcpy(header.magic, REPLAY_SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = REPLAY_SNAPSHOT_VERSION;
+    header.mode = static_cast<uint32_t>(mode);
+    header.source = parser.get_source_stamp();
+    header.position = parser.get_position();
+    header.processed_messages = processed_messages;
+    header.successful_operations = successful_operations;
+    header.failed_operations = failed_operations;
+    header.trades_executed = trades_executed;
+    header.matched_trades = matched_trades;
+    header.last_timestamp = last_timestamp;
+    header.id_count = lobster_to_internal_id.size();
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    if (!lob.save_state(out))
+        return false;
+
+    std::vector<ReplaySnapshotIdPair> pairs;
+    pairs.reserve(lobster_to_internal_id.size());
+    lobster_to_internal_id.for_each([&pairs](int lobster_id, int internal_id)
+                                    { pairs.push_back(ReplaySnapshotIdPair{lobster_id, internal_id}); });
+    out.write(reinterpret_cast<const char *>(pairs.data()),
+              static_cast<std::streamsize>(pairs.size() * sizeof(ReplaySnapshotIdPair)));
+
+    return static_cast<bool>(out);
+}
+
+bool LobsterReplayEngine::load_state(std::istream &in)
+{
+    // Start from a clean engine; the indexes keep their capacity and the snapshot sizes the rest
+    clear_state();
+
+    ReplaySnapshotHeader header;
+    if (!in.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, REPLAY_SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != REPLAY_SNAPSHOT_VERSION)
+    {
+        std::cerr << "Error: Not a replay snapshot" << std::endl;
+        return false;
+    }
+    if (!same_lobster_source(header.source, parser.get_source_stamp()))
+    {
+        std::cerr << "Error: Snapshot was taken from a different message file" << std::endl;
+        return false;
+    }
+
+    if (!lob.load_state(in))
+    {
+        std::cerr << "Error: Snapshot book is corrupt" << std::endl;
+        reset();
+        return false;
+    }
+
+    // Every live LOBSTER id maps to an order the book has handed out
+    if (header.id_count > snapshot_bytes_left(in) / sizeof(ReplaySnapshotIdPair) ||
+        header.id_count > static_cast<uint64_t>(lob.get_next_order_id()))
+    {
+        std::cerr << "Error: Snapshot id map is corrupt" << std::endl;
+        reset();
+        return false;
+    }
+
+    std::vector<ReplaySnapshotIdPair> pairs(static_cast<size_t>(header.id_count));
+    if (!in.read(reinterpret_cast<char *>(pairs.data()),
+                 static_cast<std::streamsize>(pairs.size() * sizeof(ReplaySnapshotIdPair))) ||
+        !parser.seek(header.position))
+    {
+        std::cerr << "Error: Snapshot is truncated or ends past the message file" << std::endl;
+        reset();
+        return false;
+    }
+
+    lobster_to_internal_id.reserve(pairs.size());
+    for (const ReplaySnapshotIdPair &pair : pairs)
+    {
+        if (pair.internal_id < 1 || pair.internal_id >= lob.get_next_order_id() ||
+            lobster_to_internal_id.find(pair.lobster_id))
+        {
+            std::cerr << "Error: Snapshot id map is corrupt" << std::endl;
+            reset();
+            return false;
+        }
+        lobster_to_internal_id.insert(pair.lobster_id, pair.internal_id);
+    }
+
+    ReplayMode saved_mode = header.mode == static_cast<uint32_t>(ReplayMode::RECONSTRUCTION)
+                                ? ReplayMode::RECONSTRUCTION
+                                : ReplayMode::MATCHING;
+    if (saved_mode != mode)
+        clear_checkpoints();
+    mode = saved_mode;
+    processed_messages = static_cast<int>(header.processed_messages);
+    successful_operations = static_cast<int>(header.successful_operations);
+    failed_operations = static_cast<int>(header.failed_operations);
+    trades_executed = static_cast<int>(header.trades_executed);
+    matched_trades = static_cast<int>(header.matched_trades);
+    last_timestamp = header.last_timestamp;
+    update_next_checkpoint();
+    return true;
+}
+
+bool LobsterReplayEngine::save_snapshot(const std::string &filename) const
+{
+    std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    if (!out || !save_state(out))
+    {
+        std::cerr << "Error: Cannot write snapshot " << filename << std::endl;
+        return false;
+    }
+    out.close();
+    return static_cast<bool>(out);
+}
+
+bool LobsterReplayEngine::load_snapshot(const std::string &filename)
+{
+    std::ifstream in(filename, std::ios::binary);
+    if (!in)
+    {
+        std::cerr << "Error: Cannot open snapshot " << filename << std::endl;
+        return false;
+    }
+    return load_state(in);
+}
+
+void LobsterReplayEngine::update_next_checkpoint()
+{
+    if (checkpoint_interval == 0)
+    {
+        next_checkpoint = SIZE_MAX;
+        return;
+    }
+
+    // The first cell starts at the beginning of the file, which needs no checkpoint
+    size_t cell = parser.get_current_index() / checkpoint_interval * checkpoint_interval;
+    auto first_in_cell = std::lower_bound(checkpoints.begin(), checkpoints.end(), cell,
+                                          [](const Checkpoint &checkpoint, size_t i)
+                                          { return checkpoint.message_index < i; });
+    bool occupied = cell == 0 ||
+                    (first_in_cell != checkpoints.end() && first_in_cell->message_index < cell + checkpoint_interval);
+    next_checkpoint = occupied ? cell + checkpoint_interval : cell;
+}
+
+void LobsterReplayEngine::record_checkpoint_if_due()
+{
+    if (parser.get_current_index() < next_checkpoint)
+        return;
+
+    // An existing checkpoint may have been passed since next_checkpoint was computed
+    update_next_checkpoint();
+    size_t index = parser.get_current_index();
+    if (index < next_checkpoint)
+        return;
+
+    std::ostringstream out(std::ios::binary);
+    if (!save_state(out))
+        return;
+
+    auto after = std::upper_bound(checkpoints.begin(), checkpoints.end(), index,
+                                  [](size_t i, const Checkpoint &checkpoint)
+                                  { return i < checkpoint.message_index; });
+    std::string state = out.str();
+    checkpoint_bytes += state.size();
+    checkpoints.insert(after, Checkpoint{index, last_timestamp, std::move(state)});
+    next_checkpoint = (index / checkpoint_interval + 1) * checkpoint_interval;
+    enforce_checkpoint_budget();
+}
+
+void LobsterReplayEngine::clear_checkpoints()
+{
+    checkpoints.clear();
+    checkpoint_bytes = 0;
+    checkpoint_interval = base_checkpoint_interval;
+    update_next_checkpoint();
+}
+
+void LobsterReplayEngine::enforce_checkpoint_budget()
+{
+    while (checkpoint_bytes > CHECKPOINT_BUDGET_BYTES && checkpoints.size() > 1)
+    {
+        size_t kept = 0;
+        checkpoint_bytes = 0;
+        for (size_t i = 0; i < checkpoints.size(); i += 2)
+        {
+            checkpoint_bytes += checkpoints[i].state.size();
+            checkpoints[kept++] = std::move(checkpoints[i]);
+        }
+        checkpoints.resize(kept);
+        checkpoint_interval *= 2;
+    }
+    update_next_checkpoint();
+}
+
+bool LobsterReplayEngine::seek(double timestamp)
+{
+    if (parser.get_current_index() == 0 && !parser.has_next_message())
+    {
+        std::cerr << "Error: No messages loaded" << std::endl;
+        return false;
+    }
+
+    // Seeking is what checkpoints are for; start taking them from this replay on
+    if (base_checkpoint_interval == 0)
+        set_checkpoint_interval(DEFAULT_CHECKPOINT_INTERVAL);
+
+    auto wall_start = std::chrono::steady_clock::now();
+
+    // Nearest checkpoint at or before the target
+    auto after = std::upper_bound(checkpoints.begin(), checkpoints.end(), timestamp,
+                                  [](double t, const Checkpoint &checkpoint)
+                                  { return t < checkpoint.timestamp; });
+    const Checkpoint *nearest = after == checkpoints.begin() ? nullptr : &*(after - 1);
+
+    // Carry on from here unless the target is behind us or a checkpoint is closer
+    size_t current = parser.get_current_index();
+    std::ostringstream origin;
+    if (last_timestamp <= timestamp && (!nearest || nearest->message_index <= current))
+    {
+        origin << "continued from message " << current;
+    }
+    else if (nearest)
+    {
+        std::istringstream in(nearest->state, std::ios::binary);
+        if (!load_state(in))
+            return false;
+        origin << "restored checkpoint at message " << nearest->message_index;
+    }
+    else
+    {
+        reset();
+        origin << "replayed from the start";
+    }
+
+    uint64_t loop_start = read_cycles();
+    int replayed = 0;
+    LobsterMessage msg;
+    while (parser.has_next_message() && parser.peek_next_message().timestamp <= timestamp &&
+           fetch_message(msg))
+    {
+        processed_messages++;
+        process_message(msg, false);
+        record_checkpoint_if_due();
+        replayed++;
+    }
+    replay_cycles += read_cycles() - loop_start;
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+    replay_seconds += seconds;
+
+    std::cout << "Seeked to " << std::fixed << std::setprecision(6) << timestamp << "s ("
+              << origin.str() << ", " << replayed << " messages replayed) in "
+              << std::setprecision(3) << seconds * 1000.0 << " ms; next message is "
+              << parser.get_current_index() << std::endl;
+    return true;
+}
+
+void LobsterReplayEngine::set_batch_size(size_t messages)
+{
+    batch_size = messages > 0 ? messages : 1;
+}
+
+void LobsterReplayEngine::set_checkpoint_interval(size_t messages)
+{
+    checkpoint_interval = messages;
+    base_checkpoint_interval = messages;
+    update_next_checkpoint();
+}
+
+size_t LobsterReplayEngine::get_checkpoint_count() const
+{
+    return checkpoints.size();
+}
+
+ReplayStatistics LobsterReplayEngine::get_statistics() const
+{
+    return ReplayStatistics{processed_messages, successful_operations, failed_operations,
+                            trades_executed, matched_trades, lobster_to_internal_id.size()};
+}
+
 void LobsterReplayEngine::print_statistics() const
 {
     std::cout << "\n=== REPLAY STATISTICS ===" << std::endl;
+    std::cout << "Mode: " << (mode == ReplayMode::RECONSTRUCTION ? "reconstruction" : "matching") << std::endl;
     std::cout << "Messages Processed: " << processed_messages << std::endl;
     std::cout << "Successful Operations: " << successful_operations << std::endl;
     std::cout << "Failed Operations: " << failed_operations << std::endl;
     std::cout << "Trades Executed: " << trades_executed << std::endl;
+    std::cout << "Matched Trades: " << matched_trades << std::endl;
     std::cout << "Active Orders: " << lobster_to_internal_id.size() << std::endl;
+    if (pipelined)
+    {
+        std::cout << "Pipeline Stalls: decoder " << std::fixed << std::setprecision(3)
+                  << producer_stall_seconds << "s (ring full), matcher "
+                  << consumer_stall_seconds << "s (ring empty)" << std::endl;
+    }
+    lob.get_order_pool().print_stats();
+    if (!checkpoints.empty())
+    {
+        std::cout << "Seek Checkpoints: " << checkpoints.size() << " every " << checkpoint_interval
+                  << " messages (" << std::fixed << std::setprecision(1)
+                  << checkpoint_bytes / (1024.0 * 1024.0) << " MiB)" << std::endl;
+    }
+    if (market_data)
+        market_data->print_stats();
+    print_throughput();
 
     if (processed_messages > 0)
     {
@@ -257,9 +1194,90 @@ void LobsterReplayEngine::print_statistics() const
                   << success_rate << "%" << std::endl;
     }
     std::cout << "=========================" << std::endl;
+
+    lob.get_latency().print("BOOK OPERATION LATENCY");
+    message_latency.print("MESSAGE LATENCY");
+}
+
+void LobsterReplayEngine::print_throughput() const
+{
+    if (replay_seconds > 0 && processed_messages > 0)
+    {
+        std::cout << "Replay Time: " << std::fixed << std::setprecision(3) << replay_seconds << "s ("
+                  << std::setprecision(0) << processed_messages / replay_seconds << " msgs/s)" << std::endl;
+
+        // The decoder runs on its own thread in a pipelined replay, so its time overlaps
+        double total_ns = cycles_to_ns(replay_cycles);
+        double parse_ns = cycles_to_ns(parse_cycles);
+        double match_ns = cycles_to_ns(match_cycles);
+        double other_ns = std::max(0.0, total_ns - match_ns - (pipelined ? 0.0 : parse_ns));
+        auto share = [total_ns](double ns)
+        { return total_ns > 0 ? ns / total_ns * 100.0 : 0.0; };
+
+        std::cout << std::setprecision(1) << "Time Split: parse " << share(parse_ns) << "%"
+                  << (pipelined ? " (decoder thread)" : "") << ", match " << share(match_ns)
+                  << "%, bookkeeping " << share(other_ns) << "%" << std::endl;
+    }
+
+    if (batched_messages > 0)
+    {
+        std::cout << "Batched: " << batched_messages << " messages applied in blocks of up to "
+                  << batch_size << " (the per-type rates below cover the rest)" << std::endl;
+    }
+
+    for (size_t type = 0; type < 8; type++)
+    {
+        if (type_messages[type] == 0)
+            continue;
+
+        double seconds = cycles_to_ns(type_cycles[type]) / 1e9;
+        std::cout << "  " << std::left << std::setw(21) << MESSAGE_TYPE_NAMES[type] << std::right
+                  << std::setw(10) << type_messages[type] << " msgs, " << std::setprecision(0)
+                  << std::setw(12) << (seconds > 0 ? type_messages[type] / seconds : 0.0)
+                  << " msgs/s in the book" << std::endl;
+    }
+
+    size_t rss = peak_rss_bytes();
+    if (rss > 0)
+    {
+        std::cout << "Peak RSS: " << std::setprecision(1) << rss / (1024.0 * 1024.0) << " MiB" << std::endl;
+    }
+}
+
+void LobsterReplayEngine::set_mode(ReplayMode mode)
+{
+    if (mode != this->mode)
+        clear_checkpoints();
+    this->mode = mode;
+}
+
+ReplayMode LobsterReplayEngine::get_mode() const
+{
+    return mode;
+}
+
+MarketDataFeed &LobsterReplayEngine::enable_market_data()
+{
+    if (!market_data)
+    {
+        market_data = std::make_unique<MarketDataFeed>();
+        lob.get_event_sink().attach_feed(market_data.get());
+    }
+    return *market_data;
+}
+
+void LobsterReplayEngine::disable_market_data()
+{
+    lob.get_event_sink().attach_feed(nullptr);
+    market_data.reset();
 }
 
 void LobsterReplayEngine::print_current_book() const
 {
     lob.print_book();
-}
\ No newline at end of file
+}
+
+void LobsterReplayEngine::print_current_depth(size_t levels) const
+{
+    lob.print_depth(levels);
+}
@@ -3,7 +3,99 @@
 
 #include "lob.h"
 #include "lobster_parser.h"
+#include "market_data_feed.h"
+#include "order_id_index.h"
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
 #include <unordered_map>
+#include <vector>
+
+/**
+ * @struct ReplayStatistics
+ * @brief Counters of a replay session, as shown by print_statistics.
+ */
+struct ReplayStatistics
+{
+    int processed_messages;    // Number of processed messages
+    int successful_operations; // Number of successful operations
+    int failed_operations;     // Number of failed operations
+    int trades_executed;       // Number of LOBSTER executions seen
+    int matched_trades;        // Number of trades produced by our own matching
+    size_t active_orders;      // Orders still resting in the book
+};
+
+/**
+ * @enum ReplayMode
+ * @brief How the replay engine applies historical messages to its book.
+ */
+enum class ReplayMode
+{
+    MATCHING,      /** Adds go through the matching engine, as if sent to this book. */
+    RECONSTRUCTION /** Adds rest without matching; the fastest way to rebuild the exchange's book. */
+};
+
+/**
+ * @struct ValidationReport
+ * @brief Result of comparing a replay with a LOBSTER orderbook file.
+ */
+struct ValidationReport
+{
+    size_t levels;             // Levels per side compared (0 if the file could not be read)
+    uint64_t compared;         // Messages after which the book was compared
+    uint64_t diverged;         // Messages after which the top levels differed
+    uint64_t first_divergence; // Number of the first diverging message (0 if none)
+    double first_timestamp;    // Timestamp of that message
+    size_t first_level;        // First differing level (1-based)
+    DepthLevel expected;       // That level in the orderbook file
+    DepthLevel actual;         // That level in the replay book
+    uint64_t revealed_levels;  // Levels seeded when they first came into view after the first row
+    uint64_t seeded_updates;   // Messages for orders older than the file, applied to a seeded level
+    uint64_t unknown_ids;      // Messages for unknown orders with no seeded level to apply them to
+};
+
+/**
+ * @struct ReplaySnapshotHeader
+ * @brief Header of a saved replay session.
+ *
+ * Followed by the book (see book_snapshot.h) and then id_count ReplaySnapshotIdPairs.
+ */
+struct ReplaySnapshotHeader
+{
+    char magic[8];                  // REPLAY_SNAPSHOT_MAGIC
+    uint32_t version;               // REPLAY_SNAPSHOT_VERSION
+    uint32_t mode;                  // ReplayMode the session ran in
+    LobsterSourceStamp source;      // Stamp of the message file, to reject other files
+    LobsterParserPosition position; // Next message to replay
+    int64_t processed_messages;     // Session counters, as in ReplayStatistics
+    int64_t successful_operations;
+    int64_t failed_operations;
+    int64_t trades_executed;
+    int64_t matched_trades;
+    double last_timestamp;          // Timestamp of the last replayed message (0 if none)
+    uint64_t id_count;              // Number of id pairs after the book
+};
+
+/**
+ * @struct ReplaySnapshotIdPair
+ * @brief A live LOBSTER order id and the internal id of its resting order.
+ */
+struct ReplaySnapshotIdPair
+{
+    int32_t lobster_id;  // Order id in the message file
+    int32_t internal_id; // Order id in the replay book
+};
+
+/** Identifies a saved replay session. */
+constexpr char REPLAY_SNAPSHOT_MAGIC[8] = {'L', 'O', 'B', 'R', 'E', 'P', 'L', '1'};
+
+/** Current replay snapshot format version. */
+constexpr uint32_t REPLAY_SNAPSHOT_VERSION = 3;
+
+/** Replay book type; it records the trades its own matching produces and can publish level deltas. */
+using ReplayOrderBook = BasicLimitOrderBook<DefaultPriceLevels, MarketDataSink>;
 
 /**
  * @class LobsterReplayEngine
@@ -14,25 +106,229 @@
  */
 class LobsterReplayEngine
 {
-private:
-    LimitOrderBook lob; ///< Internal limit order book instance.
-    LobsterParser parser; ///< Parser for LOBSTER-formatted data.
+public:
+    /** Default number of messages buffered between the pipelined replay threads. */
+    static constexpr size_t DEFAULT_RING_CAPACITY = 1 << 14;
+
+    /** Minimum time between progress lines of a non-verbose replay. */
+    static constexpr std::chrono::seconds PROGRESS_INTERVAL{1};
 
     /**
-     * @brief Maps LOBSTER order IDs to internal order IDs.
+     * Default number of messages applied to the book per process_batch call. Blocks skip
+     * the per-type timings and message latencies, so batching is opt-in.
      */
-    std::unordered_map<int, int> lobster_to_internal_id;
+    static constexpr size_t DEFAULT_BATCH_SIZE = 1;
+
+    /** Block size that amortises the book calls well when batching is enabled. */
+    static constexpr size_t RECOMMENDED_BATCH_SIZE = 256;
+
+    /** Messages between seek checkpoints once seeking is first requested. */
+    static constexpr size_t DEFAULT_CHECKPOINT_INTERVAL = 50000;
+
+    /** Memory the seek checkpoints may use before they are thinned out. */
+    static constexpr size_t CHECKPOINT_BUDGET_BYTES = size_t(256) << 20;
+
+private:
+    /** A snapshot of the engine taken during replay, for seek(). */
+    struct Checkpoint
+    {
+        uint64_t message_index; // Messages replayed before the checkpoint
+        double timestamp;       // Timestamp of the last of them
+        std::string state;      // Engine state written by save_state
+    };
+
+    /** How a message of a block was translated, for accounting for its result afterwards. */
+    struct BlockEntry
+    {
+        int command;     // Index of its book command, or -1 if it needed none
+        int internal_id; // Internal id the command creates or targets
+    };
+
+    ReplayOrderBook lob; ///< Internal limit order book instance.
+    ReplayMode mode;     ///< How adds are applied to the book.
+    LobsterParser parser; ///< Parser for LOBSTER-formatted data.
 
     /**
-     * @brief Maps internal order IDs to LOBSTER order IDs.
+     * @brief Maps LOBSTER order IDs to internal order IDs.
      */
-    std::unordered_map<int, int> internal_to_lobster_id;
+    OrderIdIndex<int> lobster_to_internal_id;
 
     // Statistics
     int processed_messages;      // Number of processed messages.
     int successful_operations;   // Number of successful operations.
     int failed_operations;       // Number of failed operations.
     int trades_executed;         // Number of trades executed.
+    int matched_trades;          // Number of trades produced by our own matching.
+
+    // Pipelined replay statistics
+    bool pipelined;                 // True if the last replay ran pipelined.
+    double producer_stall_seconds;  // Time the decoder waited on a full ring.
+    double consumer_stall_seconds;  // Time the matcher waited on an empty ring.
+
+    // Throughput statistics, in read_cycles() ticks unless noted
+    double replay_seconds;       // Wall-clock time spent in replay calls.
+    uint64_t replay_cycles;      // Time spent in replay loops.
+    uint64_t parse_cycles;       // Time spent fetching and decoding messages.
+    uint64_t match_cycles;       // Time spent applying messages to the book.
+    uint64_t type_messages[8];   // Messages processed, indexed by LOBSTER type.
+    uint64_t type_cycles[8];     // Time spent applying each type, indexed by LOBSTER type.
+    std::chrono::steady_clock::time_point next_progress_report; // When progress is next printed.
+
+    // Seek index: checkpoints ordered by message index (and so by timestamp)
+    std::vector<Checkpoint> checkpoints;
+    size_t checkpoint_interval;      // Messages between checkpoints, 0 (the default) to take none
+    size_t base_checkpoint_interval; // Interval set by the user, before any thinning
+    size_t checkpoint_bytes;         // Total size of the checkpoint states
+    size_t next_checkpoint;          // Parser index at which the next checkpoint is considered
+    double last_timestamp;           // Timestamp of the last replayed message, 0 before the first
+
+    // Block replay: messages are applied to the book through process_batch
+    size_t batch_size;                          // Messages per block, 1 for one call per message
+    uint64_t batched_messages;                  // Messages applied in blocks
+    std::vector<LobsterMessage> block_messages; // Messages of the current block
+    std::vector<BookCommand> block_commands;    // Their book commands
+    std::vector<int> block_results;             // Result of each command
+    std::vector<BlockEntry> block_entries;      // Per message: its command and internal id
+    OrderIdIndex<int> block_targets;            // LOBSTER ids targeted in the current segment
+
+    // Validation: one seeded order per price that has been in view in the orderbook file.
+    // Orders resting before the file starts are only known through these levels
+    std::unordered_map<Price, int> seeded_bids; // Price -> internal id of the seeded order, -1 if none was needed
+    std::unordered_map<Price, int> seeded_asks; // Price -> internal id of the seeded order, -1 if none was needed
+    uint64_t revealed_levels;                   // Levels seeded after the first row
+    bool validating;                            // Unknown ids are counted instead of reported
+    uint64_t seeded_updates;                    // Unknown-id messages applied to a seeded level
+    uint64_t unknown_id_messages;               // Unknown-id messages counted while validating
+
+    // Level-delta feed published after every message, or nullptr when disabled
+    std::unique_ptr<MarketDataFeed> market_data;
+
+    // Latency per LOBSTER message type, indexed by type (empty unless built with LATENCY=on)
+    LatencyTable message_latency;
+
+    /**
+     * @brief Fetches the next message from the parser, timing the fetch as parse time.
+     * @param msg Receives the message.
+     * @return False once the input is exhausted.
+     */
+    bool fetch_message(LobsterMessage &msg);
+
+    /**
+     * @brief Fills block_messages with up to batch_size messages, timing the fetch as parse time.
+     * @return The number of messages fetched, 0 once the input is exhausted.
+     */
+    size_t fetch_block();
+
+    /**
+     * @brief Checks whether replays may apply messages in blocks rather than one by one.
+     * @return True if blocks are enabled, no market data feed needs per-message deltas and
+     *         no seeded levels need messages for unknown ids applied in order.
+     */
+    bool use_blocks() const;
+
+    /**
+     * @brief Applies a block of messages through one process_batch call.
+     *
+     * Messages are translated to book commands first, predicting the internal ids of new
+     * orders so later messages in the block can target them; results are then accounted
+     * for in message order with the same bookkeeping, counters and warnings as
+     * process_message. Per-type timings and message latencies are not recorded.
+     * @param messages The messages.
+     * @param count Number of messages.
+     */
+    void process_block(const LobsterMessage *messages, size_t count);
+
+    /**
+     * @brief Prints a progress line if at least PROGRESS_INTERVAL has passed since the last one.
+     *
+     * The clock is only consulted every few thousand messages, so this is cheap to call per message.
+     * @param messages Messages processed since the previous call.
+     */
+    void report_progress(int messages = 1);
+
+    /**
+     * @brief Prints overall and per-type throughput, the parse/match/bookkeeping split and peak RSS.
+     */
+    void print_throughput() const;
+
+    /**
+     * @brief Clears the book, the id maps and every counter, and rewinds the parser.
+     *
+     * Unlike reset(), the id indexes keep their current capacity instead of being re-sized.
+     */
+    void clear_state();
+
+    /**
+     * @brief Saves a checkpoint once the replay enters a checkpoint_interval cell that has none.
+     *
+     * Checkpoints lie on a grid of checkpoint_interval messages, at most one per cell, so
+     * replays that reach a cell by different paths never add a near-duplicate. Only a
+     * compare against the parser index unless a checkpoint is due. Called after each
+     * message or block by the replay loops that read the parser on the matching thread.
+     */
+    void record_checkpoint_if_due();
+
+    /**
+     * @brief Recomputes next_checkpoint: the current index if its grid cell has no
+     *        checkpoint yet, otherwise the start of the next cell.
+     */
+    void update_next_checkpoint();
+
+    /**
+     * @brief Drops every checkpoint and returns to the user's checkpoint interval.
+     */
+    void clear_checkpoints();
+
+    /**
+     * @brief Keeps the checkpoints within CHECKPOINT_BUDGET_BYTES.
+     *
+     * While over budget, every other checkpoint is dropped and the interval doubled, so
+     * a day with a deep book ends up with fewer, evenly spaced checkpoints.
+     */
+    void enforce_checkpoint_budget();
+
+    /**
+     * @brief Seeds the empty book with the first snapshot of an orderbook file.
+     *
+     * The snapshot already reflects the first message. If that message is an add, its
+     * quantity is taken back out of the seeded level and the add is replayed, so the
+     * order can be tracked; any other first message is taken as applied. Each level gets
+     * one order, which later messages for pre-existing orders at that price draw down.
+     * @param first The first message.
+     * @param snapshot The first orderbook row.
+     * @param levels Number of levels in the row.
+     */
+    void seed_from_snapshot(const LobsterMessage &first, const DepthLevel *snapshot, size_t levels);
+
+    /**
+     * @brief Seeds levels that come into view in an orderbook row for the first time.
+     *
+     * A level deeper than the first row can hold orders from before the file starts. When
+     * its price first appears in a row, any quantity the row shows beyond what the replay
+     * holds at that price is rested as one seeded order at the back of the level.
+     * @param expected The orderbook row for the message just replayed.
+     * @param actual The replay book's top levels after that message.
+     * @param levels Number of levels in each.
+     * @return True if an order was seeded, so actual is out of date.
+     */
+    bool seed_revealed_levels(const DepthLevel *expected, const DepthLevel *actual, size_t levels);
+
+    /**
+     * @brief Applies a message for an order with no internal id to the seeded level at its price.
+     *
+     * Cancellations and deletions reduce the level's seeded order by the message size and
+     * visible executions fill it, so quantity resting before the file starts leaves the book.
+     * @param msg A cancellation, deletion or visible execution whose LOBSTER id is unknown.
+     * @return True if a seeded order at that price and side absorbed the message.
+     */
+    bool apply_to_seeded_level(const LobsterMessage &msg);
+
+    /**
+     * @brief Counts a message naming an unknown order, warning about it unless validating.
+     * @param operation What the message asked for, for the warning.
+     * @param msg The message.
+     */
+    void report_unknown_order(const char *operation, const LobsterMessage &msg);
 
     /**
      * @brief Processes a new order message.
@@ -64,12 +360,44 @@ private:
      */
     void process_trading_halt(const LobsterMessage &msg);
 
+    /**
+     * @brief Drops a finished order from the id maps.
+     * @param lobster_id The order's LOBSTER id; its mapping is kept if it names another order.
+     * @param internal_id The order's internal id.
+     */
+    void forget_order(int lobster_id, int internal_id);
+
+    // Bookkeeping after the book has applied a message: counters, id maps and warnings.
+    // known is false if the LOBSTER id had no internal order, in which case the book was not called
+
+    void finish_cancellation(const LobsterMessage &msg, bool known, int internal_id, int remaining);
+    void finish_deletion(const LobsterMessage &msg, bool known, int internal_id, bool deleted);
+    void finish_execution(const LobsterMessage &msg, bool known, int internal_id, int remaining);
+
+    /**
+     * @brief Counts the trades our own matching produced and clears the recorder.
+     * @param verbose If true, prints each trade.
+     */
+    void collect_trades(bool verbose);
+
+    /**
+     * @brief Dispatches one message to its handler and collects the trades it caused.
+     * @param msg The message to process.
+     * @param verbose If true, prints the trades the message produced.
+     */
+    void process_message(const LobsterMessage &msg, bool verbose);
+
     /**
      * @brief Prints information about a LOBSTER message.
      * @param msg The message to print information about.
      */
     void print_message_info(const LobsterMessage &msg);
 
+    /**
+     * @brief Pre-sizes the order ID indexes from the number of loaded messages.
+     */
+    void presize_indexes();
+
 public:
     /**
      * @brief Constructs a new LobsterReplayEngine object.
@@ -79,9 +407,12 @@ public:
     /**
      * @brief Loads LOBSTER data from a file.
      * @param filename The path to the LOBSTER data file.
+     * @param streaming If true, messages are parsed incrementally during replay with
+     *                  bounded memory instead of being loaded up front.
+     * @param parse_threads Threads used to parse a full load (0 uses every core).
      * @return True if the data was loaded successfully, false otherwise.
      */
-    bool load_data(const std::string &filename);
+    bool load_data(const std::string &filename, bool streaming = false, unsigned parse_threads = 1);
 
     /**
      * @brief Replays all loaded messages through the limit order book.
@@ -90,6 +421,43 @@ public:
      */
     void replay_all(bool verbose = false, bool step_by_step = false);
 
+    /**
+     * @brief Replays all remaining messages with decoding and matching on separate threads.
+     *
+     * A producer thread pulls messages from the parser (parsing them when streaming) and
+     * pushes them through a lock-free SPSC ring to the calling thread, which runs the
+     * order book. Time each side spends blocked on the ring is reported in the statistics.
+     * @param verbose If true, prints detailed information for each message.
+     * @param ring_capacity Number of messages the ring buffers between the two threads.
+     */
+    void replay_pipelined(bool verbose = false, size_t ring_capacity = DEFAULT_RING_CAPACITY);
+
+    /**
+     * @brief Replays from the start, comparing the top levels with a LOBSTER orderbook file
+     *        after every message.
+     *
+     * Rows are streamed in lockstep with messages. The book is seeded from the first row,
+     * so orders resting before the file starts are present, and messages for those orders
+     * are applied to the seeded level at their price; they are counted rather than
+     * reported one by one. Replay continues past a divergence so the divergence rate
+     * covers the whole file.
+     * @param orderbook_filename The orderbook_*.csv matching the loaded message file.
+     * @return The comparison summary.
+     */
+    ValidationReport replay_validate(const std::string &orderbook_filename);
+
+    /**
+     * @brief Replays all remaining messages without printing progress or a summary.
+     * @return The number of messages replayed.
+     */
+    int replay_silent();
+
+    /**
+     * @brief Applies a single message to the book, as if it came from the loaded file.
+     * @param msg The message to apply.
+     */
+    void process(const LobsterMessage &msg);
+
     /**
      * @brief Replays the first n messages through the limit order book.
      * @param n Number of messages to replay.
@@ -99,18 +467,132 @@ public:
 
     /**
      * @brief Resets the engine state and statistics.
+     *
+     * Seek checkpoints are kept; they stay valid until another file is loaded or the mode changes.
      */
     void reset();
 
+    /**
+     * @brief Moves the replay to just after the last message at or before a timestamp.
+     *
+     * The first seek turns on checkpointing at DEFAULT_CHECKPOINT_INTERVAL unless an
+     * interval was set; from then on, replays that read messages on one thread (everything
+     * but pipelined replays and validation) checkpoint the engine every interval. A seek restores the
+     * nearest checkpoint at or before the timestamp, or carries on from the current
+     * position if that is closer, and replays only the messages in between, adding
+     * checkpoints past the end of the index as it goes. Timing statistics restart
+     * when a checkpoint is restored.
+     * @param timestamp Target time in seconds after midnight.
+     * @return False if no messages are loaded.
+     */
+    bool seek(double timestamp);
+
+    /**
+     * @brief Sets how many messages non-verbose replays apply per book batch.
+     *
+     * Results are identical for every size; 1 (the default) calls the book once per message
+     * and is the only size that records per-type rates and message latencies.
+     * @param messages Messages per block (0 is treated as 1).
+     */
+    void set_batch_size(size_t messages);
+
+    /**
+     * @brief Sets how often checkpoints are taken; existing ones are kept.
+     *
+     * Checkpointing is off until this is called or seek() is first used, so replays that
+     * never seek hold no engine copies. The interval doubles whenever the checkpoints outgrow CHECKPOINT_BUDGET_BYTES.
+     * @param messages Messages between checkpoints, 0 to stop taking them.
+     */
+    void set_checkpoint_interval(size_t messages);
+
+    /**
+     * @brief Gets the number of checkpoints in the seek index.
+     * @return The checkpoint count.
+     */
+    size_t get_checkpoint_count() const;
+
+    /**
+     * @brief Writes the book, the id maps, the counters and the parser position as a binary snapshot.
+     *
+     * Timing statistics and market data outputs are not part of the snapshot.
+     * @param out Binary stream to write to.
+     * @return True if everything was written.
+     */
+    bool save_state(std::ostream &out) const;
+
+    /**
+     * @brief Restores a session written by save_state so replay resumes where it was taken.
+     *
+     * The message file the snapshot was taken from must be loaded (in any form: CSV,
+     * stream or cache). The book and the id maps are sized once and filled in bulk.
+     * @param in Binary stream to read from.
+     * @return False if the snapshot is malformed or belongs to another file; the
+     *         engine is then reset to the beginning.
+     */
+    bool load_state(std::istream &in);
+
+    /**
+     * @brief Saves the session to a snapshot file.
+     * @param filename Path of the file; an existing file is overwritten.
+     * @return True on success.
+     */
+    bool save_snapshot(const std::string &filename) const;
+
+    /**
+     * @brief Restores the session from a snapshot file.
+     * @param filename Path of a file written by save_snapshot.
+     * @return True on success.
+     */
+    bool load_snapshot(const std::string &filename);
+
+    /**
+     * @brief Gets the counters of the replay session.
+     * @return The current statistics.
+     */
+    ReplayStatistics get_statistics() const;
+
     /**
      * @brief Prints statistics about the replay session.
      */
     void print_statistics() const;
 
+    /**
+     * @brief Chooses how historical adds are applied; it stays in effect across resets.
+     *
+     * Changing the mode drops the seek checkpoints, which were taken in the old mode.
+     * @param mode The replay mode.
+     */
+    void set_mode(ReplayMode mode);
+
+    /**
+     * @brief Gets the replay mode.
+     * @return The current mode.
+     */
+    ReplayMode get_mode() const;
+
+    /**
+     * @brief Starts publishing coalesced level deltas after every replayed message.
+     *
+     * The feed survives reset(); attach its outputs through the returned reference.
+     * @return The engine's market data feed.
+     */
+    MarketDataFeed &enable_market_data();
+
+    /**
+     * @brief Stops publishing level deltas and closes the feed's file, if any.
+     */
+    void disable_market_data();
+
     /**
      * @brief Prints the current state of the limit order book.
      */
     void print_current_book() const;
+
+    /**
+     * @brief Prints the top levels of the limit order book.
+     * @param levels Number of levels per side to print.
+     */
+    void print_current_depth(size_t levels) const;
 };
 
 #endif // LOBSTER_REPLAY_H
\ No newline at end of file
@@ -1,14 +1,25 @@
+#include "book_manager.h"
 #include "lob.h"
+#include "lobster_cache.h"
 #include "lobster_replay.h"
+#include "order_flow.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
+// The interactive book prints its trades as they happen
+using CliOrderBook = BasicLimitOrderBook<DefaultPriceLevels, PrintingEventSink>;
+
 class LOBSimulator
 {
 private:
-    LimitOrderBook lob;
+    CliOrderBook lob;
     LobsterReplayEngine replay_engine;
 
     std::vector<std::string> split(const std::string &str, char delimiter)
@@ -28,6 +39,32 @@ private:
         return tokens;
     }
 
+    // LOBSTER files are named <TICKER>_<date>_..._message_<levels>.csv
+    std::string symbol_from_filename(const std::string &filename)
+    {
+        size_t start = filename.find_last_of("/\\");
+        start = start == std::string::npos ? 0 : start + 1;
+        size_t end = filename.find('_', start);
+        if (end == std::string::npos)
+            end = filename.find('.', start);
+        return filename.substr(start, end == std::string::npos ? std::string::npos : end - start);
+    }
+
+    // Seconds after midnight from "34200.5" or a wall-clock "HH:MM[:SS[.fff]]"
+    double parse_time_of_day(const std::string &text)
+    {
+        auto fields = split(text, ':');
+        if (fields.size() < 2)
+            return std::stod(text);
+        if (fields.size() > 3)
+            throw std::invalid_argument("Invalid time: " + text);
+
+        double seconds = std::stoi(fields[0]) * 3600.0 + std::stoi(fields[1]) * 60.0;
+        if (fields.size() == 3)
+            seconds += std::stod(fields[2]);
+        return seconds;
+    }
+
     void print_help()
     {
         std::cout << "\n=== LOB SIMULATOR COMMANDS ===" << std::endl;
@@ -37,13 +74,28 @@ private:
         std::cout << "market buy <quantity>          - Execute market buy order" << std::endl;
         std::cout << "market sell <quantity>         - Execute market sell order" << std::endl;
         std::cout << "cancel <order_id>              - Cancel order by ID" << std::endl;
+        std::cout << "reduce <order_id> <quantity>   - Reduce order quantity, keeping priority" << std::endl;
         std::cout << "print                          - Display current book state" << std::endl;
+        std::cout << "depth [n] [replay]             - Display top n levels (default 10) of a book" << std::endl;
+        std::cout << "pool                           - Show order pool usage" << std::endl;
+        std::cout << "generate <n> [file] [hawkes]   - Run n synthetic events (optionally save as LOBSTER)" << std::endl;
         std::cout << "\n=== LOBSTER Data Replay ===" << std::endl;
-        std::cout << "load <filename>                - Load LOBSTER CSV file" << std::endl;
+        std::cout << "load <filename> [stream|parallel] - Load LOBSTER CSV file" << std::endl;
+        std::cout << "                                   (stream: bounded memory, parallel: all cores)" << std::endl;
+        std::cout << "convert <filename> [output]    - Convert LOBSTER CSV to a binary cache" << std::endl;
+        std::cout << "mode <matching|reconstruction> - Match historical adds, or rest them and apply fills" << std::endl;
         std::cout << "replay all [verbose] [step]    - Replay all messages" << std::endl;
+        std::cout << "replay all pipelined [verbose] - Replay with decoding on its own thread" << std::endl;
         std::cout << "replay <n> [verbose]           - Replay next n messages" << std::endl;
+        std::cout << "batch <n>                      - Messages per book batch in quiet replays (default 1 = per message)" << std::endl;
+        std::cout << "validate <orderbook_file>      - Replay from the start, checking each step against LOBSTER's book" << std::endl;
+        std::cout << "multi <file> [file...]         - Replay several symbols' files in parallel" << std::endl;
+        std::cout << "feed <file> | feed off         - Write replay level deltas to a binary file" << std::endl;
+        std::cout << "seek <time>                    - Jump the replay to a time (seconds or HH:MM[:SS])" << std::endl;
+        std::cout << "snapshot <file>                - Save the replay book, id maps and position" << std::endl;
+        std::cout << "restore <file>                 - Resume a replay from a snapshot of the loaded file" << std::endl;
         std::cout << "reset                          - Reset replay to beginning" << std::endl;
-        std::cout << "stats                          - Show replay statistics" << std::endl;
+        std::cout << "stats                          - Show replay statistics and latency histograms" << std::endl;
         std::cout << "\n=== General ===" << std::endl;
         std::cout << "help                           - Show this help message" << std::endl;
         std::cout << "exit                           - Exit simulator" << std::endl;
@@ -87,16 +139,99 @@ public:
                 {
                     lob.print_book();
                 }
+                else if (command == "depth")
+                {
+                    size_t levels = 10;
+                    bool replay_book = false;
+                    for (size_t i = 1; i < tokens.size(); i++)
+                    {
+                        if (tokens[i] == "replay")
+                            replay_book = true;
+                        else
+                            levels = std::stoul(tokens[i]);
+                    }
+
+                    if (levels == 0)
+                    {
+                        std::cout << "Usage: depth [n] [replay]" << std::endl;
+                        continue;
+                    }
+                    if (replay_book)
+                        replay_engine.print_current_depth(levels);
+                    else
+                        lob.print_depth(levels);
+                }
+                else if (command == "pool")
+                {
+                    lob.get_order_pool().print_stats();
+                }
+                else if (command == "generate")
+                {
+                    if (tokens.size() < 2 || tokens.size() > 4)
+                    {
+                        std::cout << "Usage: generate <n> [file] [hawkes]" << std::endl;
+                        continue;
+                    }
+
+                    long long count = std::stoll(tokens[1]);
+                    if (count <= 0)
+                    {
+                        std::cout << "Error: Number of events must be positive" << std::endl;
+                        continue;
+                    }
+
+                    OrderFlowConfig config;
+                    std::string filename;
+                    for (size_t i = 2; i < tokens.size(); i++)
+                    {
+                        if (tokens[i] == "hawkes")
+                            config.arrivals = ArrivalProcess::HAWKES;
+                        else
+                            filename = tokens[i];
+                    }
+
+                    std::ofstream file;
+                    if (!filename.empty())
+                    {
+                        file.open(filename);
+                        if (!file.is_open())
+                        {
+                            std::cout << "Error: Cannot open file " << filename << std::endl;
+                            continue;
+                        }
+                    }
+
+                    OrderFlowGenerator generator(config);
+                    FlowOrderBook book;
+                    OrderFlowStats stats = run_order_flow(generator, static_cast<size_t>(count), book,
+                                                          filename.empty() ? nullptr : &file);
+
+                    std::cout << "Generated " << stats.events << " events ("
+                              << stats.adds << " adds, " << stats.cancels << " cancels, "
+                              << stats.markets << " market orders, " << stats.trades << " trades)" << std::endl;
+                    std::cout << "Simulated " << std::fixed << std::setprecision(3)
+                              << stats.last_timestamp - stats.first_timestamp << "s of flow in "
+                              << stats.seconds << "s (" << std::setprecision(0)
+                              << stats.events / stats.seconds << " events/s)" << std::endl;
+                    std::cout << "Resting: " << generator.live_orders(OrderSide::BUY) << " bids, "
+                              << generator.live_orders(OrderSide::SELL) << " asks" << std::endl;
+                    book.get_order_pool().print_stats();
+                    book.print_book();
+                    if (!filename.empty())
+                        std::cout << "Wrote LOBSTER messages to " << filename << std::endl;
+                }
                 else if (command == "load")
                 {
-                    if (tokens.size() != 2)
+                    bool streaming = tokens.size() == 3 && tokens[2] == "stream";
+                    bool parallel = tokens.size() == 3 && tokens[2] == "parallel";
+                    if (tokens.size() != 2 && !streaming && !parallel)
                     {
-                        std::cout << "Usage: load <filename>" << std::endl;
+                        std::cout << "Usage: load <filename> [stream|parallel]" << std::endl;
                         continue;
                     }
 
                     std::string filename = tokens[1];
-                    if (replay_engine.load_data(filename))
+                    if (replay_engine.load_data(filename, streaming, parallel ? 0 : 1))
                     {
                         std::cout << "LOBSTER data loaded successfully!" << std::endl;
                     }
@@ -105,17 +240,40 @@ public:
                         std::cout << "Failed to load LOBSTER data from " << filename << std::endl;
                     }
                 }
+                else if (command == "convert")
+                {
+                    if (tokens.size() != 2 && tokens.size() != 3)
+                    {
+                        std::cout << "Usage: convert <filename> [output]" << std::endl;
+                        continue;
+                    }
+
+                    std::string filename = tokens[1];
+                    std::string output = tokens.size() == 3 ? tokens[2] : lobster_cache_path(filename);
+
+                    // Always parse the CSV itself, even if an older cache exists
+                    LobsterParser converter;
+                    if (converter.load_file(filename, false) && converter.write_cache(output))
+                    {
+                        std::cout << "Wrote binary cache " << output << std::endl;
+                    }
+                    else
+                    {
+                        std::cout << "Failed to convert " << filename << std::endl;
+                    }
+                }
                 else if (command == "replay")
                 {
                     if (tokens.size() < 2)
                     {
-                        std::cout << "Usage: replay <all|n> [verbose] [step]" << std::endl;
+                        std::cout << "Usage: replay <all|n> [verbose] [step] [pipelined]" << std::endl;
                         continue;
                     }
 
                     std::string mode = tokens[1];
                     bool verbose = false;
                     bool step_by_step = false;
+                    bool pipelined = false;
 
                     // Check for verbose and step flags
                     for (size_t i = 2; i < tokens.size(); i++)
@@ -124,9 +282,15 @@ public:
                             verbose = true;
                         if (tokens[i] == "step")
                             step_by_step = true;
+                        if (tokens[i] == "pipelined")
+                            pipelined = true;
                     }
 
-                    if (mode == "all")
+                    if (mode == "all" && pipelined)
+                    {
+                        replay_engine.replay_pipelined(verbose);
+                    }
+                    else if (mode == "all")
                     {
                         replay_engine.replay_all(verbose, step_by_step);
                     }
@@ -148,14 +312,119 @@ public:
                         }
                     }
                 }
+                else if (command == "multi")
+                {
+                    if (tokens.size() < 2)
+                    {
+                        std::cout << "Usage: multi <file> [file...]" << std::endl;
+                        continue;
+                    }
+
+                    BookManager manager;
+                    bool loaded = true;
+                    for (size_t i = 1; i < tokens.size() && loaded; i++)
+                        loaded = manager.load_symbol(symbol_from_filename(tokens[i]), tokens[i]);
+
+                    if (!loaded)
+                    {
+                        std::cout << "Failed to load LOBSTER data" << std::endl;
+                        continue;
+                    }
+
+                    manager.start();
+                    manager.finish();
+                    manager.print_statistics();
+                }
                 else if (command == "reset")
                 {
                     replay_engine.reset();
                     std::cout << "Replay engine reset to beginning" << std::endl;
                 }
+                else if (command == "mode")
+                {
+                    if (tokens.size() != 2 || (tokens[1] != "matching" && tokens[1] != "reconstruction"))
+                    {
+                        std::cout << "Usage: mode <matching|reconstruction>" << std::endl;
+                        continue;
+                    }
+                    replay_engine.set_mode(tokens[1] == "reconstruction" ? ReplayMode::RECONSTRUCTION
+                                                                         : ReplayMode::MATCHING);
+                    std::cout << "Replay mode: " << tokens[1] << std::endl;
+                }
+                else if (command == "validate")
+                {
+                    if (tokens.size() != 2)
+                    {
+                        std::cout << "Usage: validate <orderbook_file>" << std::endl;
+                        continue;
+                    }
+                    replay_engine.replay_validate(tokens[1]);
+                }
+                else if (command == "feed")
+                {
+                    if (tokens.size() != 2)
+                    {
+                        std::cout << "Usage: feed <file> | feed off" << std::endl;
+                        continue;
+                    }
+
+                    if (tokens[1] == "off")
+                    {
+                        replay_engine.disable_market_data();
+                        std::cout << "Market data feed stopped" << std::endl;
+                    }
+                    else if (replay_engine.enable_market_data().open_file(tokens[1]))
+                        std::cout << "Publishing level deltas to " << tokens[1] << std::endl;
+                    else
+                        std::cout << "Error: Could not open " << tokens[1] << std::endl;
+                }
+                else if (command == "batch")
+                {
+                    if (tokens.size() != 2)
+                    {
+                        std::cout << "Usage: batch <messages>" << std::endl;
+                        continue;
+                    }
+                    int messages = std::stoi(tokens[1]);
+                    replay_engine.set_batch_size(messages > 0 ? static_cast<size_t>(messages) : 1);
+                    std::cout << "Replay batch size: " << std::max(messages, 1) << std::endl;
+                }
+                else if (command == "seek")
+                {
+                    if (tokens.size() != 2)
+                    {
+                        std::cout << "Usage: seek <seconds after midnight | HH:MM[:SS]>" << std::endl;
+                        continue;
+                    }
+                    replay_engine.seek(parse_time_of_day(tokens[1]));
+                }
+                else if (command == "snapshot" || command == "restore")
+                {
+                    if (tokens.size() != 2)
+                    {
+                        std::cout << "Usage: " << command << " <file>" << std::endl;
+                        continue;
+                    }
+
+                    auto start = std::chrono::steady_clock::now();
+                    bool saving = command == "snapshot";
+                    bool success = saving ? replay_engine.save_snapshot(tokens[1])
+                                          : replay_engine.load_snapshot(tokens[1]);
+                    if (success)
+                    {
+                        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                        ReplayStatistics stats = replay_engine.get_statistics();
+                        std::cout << (saving ? "Saved " : "Restored ") << stats.active_orders << " orders at message "
+                                  << stats.processed_messages << (saving ? " to " : " from ") << tokens[1]
+                                  << " in " << std::fixed << std::setprecision(3) << seconds << "s" << std::endl;
+                    }
+                }
                 else if (command == "stats")
                 {
                     replay_engine.print_statistics();
+                    lob.get_latency().print("INTERACTIVE BOOK LATENCY");
+                    if (!LATENCY_STATS_ENABLED)
+                        std::cout << "(Latency histograms are compiled out; rebuild with make LATENCY=on)" << std::endl;
                 }
                 else if (command == "limit")
                 {
@@ -166,7 +435,7 @@ public:
                     }
 
                     std::string side_str = tokens[1];
-                    double price = std::stod(tokens[2]);
+                    Price price = price_from_double(std::stod(tokens[2]));
                     int quantity = std::stoi(tokens[3]);
 
                     if (quantity <= 0)
@@ -256,6 +525,37 @@ public:
                     }
                     lob.print_book();
                 }
+                else if (command == "reduce")
+                {
+                    if (tokens.size() != 3)
+                    {
+                        std::cout << "Usage: reduce <order_id> <quantity>" << std::endl;
+                        continue;
+                    }
+
+                    int order_id = std::stoi(tokens[1]);
+                    int quantity = std::stoi(tokens[2]);
+                    if (quantity <= 0)
+                    {
+                        std::cout << "Error: Quantity must be positive" << std::endl;
+                        continue;
+                    }
+
+                    int remaining = lob.reduce_order(order_id, quantity);
+                    if (remaining > 0)
+                    {
+                        std::cout << "Order " << order_id << " reduced to " << remaining << " shares" << std::endl;
+                    }
+                    else if (remaining == 0)
+                    {
+                        std::cout << "Order " << order_id << " cancelled successfully" << std::endl;
+                    }
+                    else
+                    {
+                        std::cout << "Order " << order_id << " not found" << std::endl;
+                    }
+                    lob.print_book();
+                }
                 else
                 {
                     std::cout << "Unknown command: " << command << std::endl;
@@ -0,0 +1,121 @@
+#include "mapped_file.h"
+#include <algorithm>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define LOB_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#endif
+
+MappedFile::MappedFile() : view(nullptr), length(0), mapped(false), discarded(0) {}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const std::string &filename)
+{
+    close();
+
+#ifdef LOB_HAVE_MMAP
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    length = static_cast<size_t>(st.st_size);
+    if (length > 0)
+    {
+        void *region = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (region == MAP_FAILED)
+        {
+            ::close(fd);
+            length = 0;
+            return false;
+        }
+
+        // Parsing walks the file front to back; let the kernel read ahead aggressively
+        madvise(region, length, MADV_SEQUENTIAL);
+        view = static_cast<const char *>(region);
+        mapped = true;
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    ::close(fd);
+    return true;
+#else
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+        return false;
+
+    length = static_cast<size_t>(file.tellg());
+    buffer.resize(length);
+    file.seekg(0);
+    file.read(buffer.data(), static_cast<std::streamsize>(length));
+    view = buffer.data();
+    return true;
+#endif
+}
+
+void MappedFile::discard_before(size_t offset)
+{
+#ifdef LOB_HAVE_MMAP
+    if (!mapped)
+        return;
+
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t end = std::min(offset, length);
+    end -= end % page;
+    if (end > discarded)
+    {
+        madvise(const_cast<char *>(view) + discarded, end - discarded, MADV_DONTNEED);
+        discarded = end;
+    }
+#else
+    (void)offset;
+#endif
+}
+
+void MappedFile::rewind(size_t offset)
+{
+#ifdef LOB_HAVE_MMAP
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    discarded = std::min(discarded, offset - offset % page);
+#else
+    (void)offset;
+#endif
+}
+
+void MappedFile::close()
+{
+#ifdef LOB_HAVE_MMAP
+    if (mapped)
+        munmap(const_cast<char *>(view), length);
+#endif
+    view = nullptr;
+    length = 0;
+    mapped = false;
+    discarded = 0;
+    buffer.clear();
+}
+
+const char *MappedFile::data() const
+{
+    return view;
+}
+
+size_t MappedFile::size() const
+{
+    return length;
+}
@@ -0,0 +1,82 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @class MappedFile
+ * @brief Read-only view of a whole file, memory-mapped where the platform allows it.
+ *
+ * On POSIX systems the file is mapped with mmap and pages are faulted in on demand,
+ * so nothing is copied. Elsewhere the file is read into an owned buffer.
+ */
+class MappedFile
+{
+private:
+    const char *view;         // Start of the file contents
+    size_t length;            // Size of the file in bytes
+    bool mapped;              // True if view points at an mmap region
+    size_t discarded;         // Bytes at the start of the mapping already handed back
+    std::vector<char> buffer; // Fallback storage when mmap is unavailable
+
+public:
+    /**
+     * @brief Constructs an empty, unopened view.
+     */
+    MappedFile();
+
+    /**
+     * @brief Unmaps the file if one is open.
+     */
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    /**
+     * @brief Maps a file, closing any file that was previously open.
+     * @param filename Path to the file.
+     * @return True if the file was opened, false otherwise.
+     */
+    bool open(const std::string &filename);
+
+    /**
+     * @brief Tells the kernel the file contents before an offset will not be read again.
+     *
+     * Resident pages before the offset are dropped, which keeps memory bounded while a
+     * large file is read front to back. They are faulted back in if read again. Without
+     * mmap the whole file is held in one buffer and this does nothing.
+     * @param offset Byte offset; whole pages before it are released.
+     */
+    void discard_before(size_t offset);
+
+    /**
+     * @brief Tells the mapping the reader is going back to an offset.
+     *
+     * Pages from there on may be faulted back in, so the mark below which pages count as
+     * released is lowered to it; later discard_before calls release them again.
+     * @param offset Byte offset the reader continues from.
+     */
+    void rewind(size_t offset);
+
+    /**
+     * @brief Releases the current mapping.
+     */
+    void close();
+
+    /**
+     * @brief Gets the start of the file contents.
+     * @return A pointer to the first byte, or nullptr if nothing is open or the file is empty.
+     */
+    const char *data() const;
+
+    /**
+     * @brief Gets the size of the file.
+     * @return The size in bytes.
+     */
+    size_t size() const;
+};
+
+#endif // MAPPED_FILE_H
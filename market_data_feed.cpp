@@ -0,0 +1,71 @@
+#include "market_data_feed.h"
+#include <cstring>
+#include <iostream>
+
+MarketDataFeed::MarketDataFeed() : ring(nullptr), level_updates(0), published(0), dropped(0)
+{
+    pending.reserve(PENDING_RESERVE);
+}
+
+void MarketDataFeed::publish(uint64_t sequence, double timestamp)
+{
+    if (pending.empty())
+        return;
+
+    for (LevelDelta &delta : pending)
+    {
+        delta.sequence = sequence;
+        delta.timestamp = timestamp;
+        if (ring && !ring->try_push(delta))
+            dropped++;
+    }
+
+    if (file.is_open())
+    {
+        file.write(reinterpret_cast<const char *>(pending.data()),
+                   static_cast<std::streamsize>(pending.size() * sizeof(LevelDelta)));
+    }
+
+    published += pending.size();
+    pending.clear();
+}
+
+void MarketDataFeed::attach_ring(SpscRing<LevelDelta> *ring)
+{
+    this->ring = ring;
+}
+
+bool MarketDataFeed::open_file(const std::string &filename)
+{
+    close_file();
+    file.open(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+        return false;
+
+    LevelDeltaFileHeader header{};
+    std::memcpy(header.magic, LEVEL_DELTA_MAGIC, sizeof(LEVEL_DELTA_MAGIC));
+    header.version = LEVEL_DELTA_VERSION;
+    header.record_size = sizeof(LevelDelta);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    return static_cast<bool>(file);
+}
+
+void MarketDataFeed::close_file()
+{
+    if (file.is_open())
+        file.close();
+}
+
+uint64_t MarketDataFeed::get_published() const
+{
+    return published;
+}
+
+void MarketDataFeed::print_stats() const
+{
+    std::cout << "Market Data: " << level_updates << " level updates, " << published
+              << " deltas published";
+    if (dropped > 0)
+        std::cout << ", " << dropped << " dropped (ring full)";
+    std::cout << std::endl;
+}
@@ -0,0 +1,187 @@
+#ifndef MARKET_DATA_FEED_H
+#define MARKET_DATA_FEED_H
+
+#include "lob.h"
+#include "lob_events.h"
+#include "order.h"
+#include "spsc_ring.h"
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * @struct LevelDelta
+ * @brief One L2 update: the new aggregate state of a price level after an input message.
+ *
+ * Fixed 40-byte layout so feed files can be read back with a single read per batch.
+ */
+struct LevelDelta
+{
+    uint64_t sequence;    // Number of the input message that produced the update
+    double timestamp;     // Timestamp of that message (seconds after midnight)
+    int64_t price;        // Level price in ticks
+    int32_t quantity;     // New aggregate quantity (0 once the level is gone)
+    uint32_t order_count; // New number of resting orders
+    int8_t side;          // 1 = bid, -1 = ask (LOBSTER direction convention)
+    uint8_t reserved[7];  // Zero
+};
+
+static_assert(sizeof(LevelDelta) == 40, "LevelDelta must keep its on-disk layout");
+
+/**
+ * @struct LevelDeltaFileHeader
+ * @brief Header at the start of a feed file, followed by LevelDelta records until EOF.
+ */
+struct LevelDeltaFileHeader
+{
+    char magic[8];        // LEVEL_DELTA_MAGIC
+    uint32_t version;     // LEVEL_DELTA_VERSION
+    uint32_t record_size; // sizeof(LevelDelta)
+};
+
+/** Identifies a level-delta feed file. */
+constexpr char LEVEL_DELTA_MAGIC[8] = {'L', 'O', 'B', 'D', 'E', 'L', 'T', 'A'};
+
+/** Current feed file format version. */
+constexpr uint32_t LEVEL_DELTA_VERSION = 1;
+
+/**
+ * @class MarketDataFeed
+ * @brief Publishes coalesced L2 level deltas to an in-memory ring and/or a binary file.
+ *
+ * Level changes reported by the book during one input message are collected and
+ * coalesced, so a level touched several times (e.g. by a sweep that partially fills
+ * it) yields a single delta with its final state. publish() ends the message and
+ * emits the collected deltas in the order their levels were first touched.
+ */
+class MarketDataFeed
+{
+public:
+    /** Initial capacity of the per-message coalescing buffer. */
+    static constexpr size_t PENDING_RESERVE = 256;
+
+private:
+    std::vector<LevelDelta> pending; // Deltas of the current message, one per level
+    SpscRing<LevelDelta> *ring;      // Ring to publish to, or nullptr
+    std::ofstream file;              // File to publish to, if open
+
+    // Statistics
+    uint64_t level_updates; // Level changes reported by the book
+    uint64_t published;     // Deltas published after coalescing
+    uint64_t dropped;       // Deltas lost because the ring was full
+
+public:
+    /**
+     * @brief Constructs a feed with no outputs attached.
+     */
+    MarketDataFeed();
+
+    /**
+     * @brief Collects a level change into the current message's deltas.
+     * @param level The level's new aggregate state.
+     */
+    void on_level_changed(const LevelEvent &level)
+    {
+        level_updates++;
+        int8_t side = level.side == OrderSide::BUY ? 1 : -1;
+
+        // A message touches few levels, so a linear scan beats hashing
+        for (LevelDelta &delta : pending)
+        {
+            if (delta.price == level.price && delta.side == side)
+            {
+                delta.quantity = level.total_quantity;
+                delta.order_count = static_cast<uint32_t>(level.order_count);
+                return;
+            }
+        }
+
+        LevelDelta delta{};
+        delta.price = level.price;
+        delta.quantity = level.total_quantity;
+        delta.order_count = static_cast<uint32_t>(level.order_count);
+        delta.side = side;
+        pending.push_back(delta);
+    }
+
+    /**
+     * @brief Ends an input message and publishes its coalesced deltas.
+     *
+     * The ring is never waited on: deltas that do not fit are counted as dropped.
+     * @param sequence Number of the input message.
+     * @param timestamp Timestamp of the input message.
+     */
+    void publish(uint64_t sequence, double timestamp);
+
+    /**
+     * @brief Publishes to a ring read by another thread.
+     * @param ring The ring, or nullptr to stop publishing to a ring.
+     */
+    void attach_ring(SpscRing<LevelDelta> *ring);
+
+    /**
+     * @brief Opens a binary feed file and writes its header.
+     * @param filename Path of the file; an existing file is overwritten.
+     * @return True on success.
+     */
+    bool open_file(const std::string &filename);
+
+    /**
+     * @brief Flushes and closes the feed file, if one is open.
+     */
+    void close_file();
+
+    /**
+     * @brief Gets the number of deltas published.
+     * @return The published count.
+     */
+    uint64_t get_published() const;
+
+    /**
+     * @brief Prints level updates, published deltas and drops.
+     */
+    void print_stats() const;
+};
+
+/**
+ * @class MarketDataSink
+ * @brief Event sink that records trades like TradeRecorder and forwards level changes to a feed.
+ *
+ * With no feed attached, level changes cost a single branch.
+ */
+class MarketDataSink : public TradeRecorder
+{
+private:
+    MarketDataFeed *feed; // Receiver of level changes, or nullptr
+
+public:
+    /**
+     * @brief Constructs a sink with no feed attached.
+     * @param capacity Maximum number of trades held before dropping.
+     */
+    explicit MarketDataSink(size_t capacity = DEFAULT_CAPACITY) : TradeRecorder(capacity), feed(nullptr) {}
+
+    /**
+     * @brief Attaches the feed that level changes are forwarded to.
+     * @param feed The feed, or nullptr to stop forwarding.
+     */
+    void attach_feed(MarketDataFeed *feed) { this->feed = feed; }
+
+    /**
+     * @brief Forwards a level change to the attached feed.
+     * @param level The level's new aggregate state.
+     */
+    void on_level_changed(const LevelEvent &level)
+    {
+        if (feed)
+            feed->on_level_changed(level);
+    }
+};
+
+// Books publishing market data are compiled once in lob.cpp, with the other sinks
+extern template class BasicLimitOrderBook<MapPriceLevels, MarketDataSink>;
+extern template class BasicLimitOrderBook<LadderPriceLevels, MarketDataSink>;
+
+#endif // MARKET_DATA_FEED_H
@@ -0,0 +1,153 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief Tells the CPU the calling thread is spinning, easing pressure on its sibling hyperthread.
+ */
+inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+/**
+ * @class MpscQueue
+ * @brief Bounded lock-free queue for any number of producer threads and one consumer thread.
+ *
+ * Every slot carries a sequence number saying whose turn it is: producers claim a
+ * position with a single compare-and-swap on the tail, write the slot and publish it by
+ * advancing its sequence, so producers never wait on each other's writes. The consumer
+ * owns the head outright and needs no atomic read-modify-write at all. A producer that
+ * is preempted between claiming and publishing holds up the consumer at that slot only.
+ * A full queue pushes back on producers (try_push fails).
+ *
+ * @tparam T The element type. Must be default constructible and copy assignable.
+ */
+template <typename T>
+class MpscQueue
+{
+public:
+    /** Assumed cache line size; slots and the two ends are aligned to it. */
+    static constexpr size_t CACHE_LINE = 64;
+
+private:
+    struct alignas(CACHE_LINE) Slot
+    {
+        std::atomic<size_t> sequence; // Position + 1 once written, position + capacity once read
+        T value;                      // The element
+    };
+
+    std::unique_ptr<Slot[]> slots; // Ring storage, a power of two in size
+    size_t mask;                   // Capacity - 1
+
+    alignas(CACHE_LINE) std::atomic<size_t> tail; // Next position producers will claim
+    alignas(CACHE_LINE) size_t head;              // Next position the consumer reads
+
+    static size_t round_up(size_t n)
+    {
+        size_t capacity = 2;
+        while (capacity < n)
+            capacity <<= 1;
+        return capacity;
+    }
+
+public:
+    /**
+     * @brief Constructs an empty queue.
+     * @param capacity Minimum number of elements the queue holds (rounded up to a power of two).
+     */
+    explicit MpscQueue(size_t capacity)
+        : slots(new Slot[round_up(capacity)]), mask(round_up(capacity) - 1), tail(0), head(0)
+    {
+        for (size_t i = 0; i <= mask; i++)
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+    /**
+     * @brief Appends an element. Any thread.
+     * @param value The element to append.
+     * @return True if it was appended, false if the queue is full.
+     */
+    bool try_push(const T &value)
+    {
+        size_t position = tail.load(std::memory_order_relaxed);
+        while (true)
+        {
+            Slot &slot = slots[position & mask];
+            size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            intptr_t lag = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+
+            if (lag == 0)
+            {
+                // The slot is free for this position; claim it unless another producer did
+                if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    slot.value = value;
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (lag < 0)
+                return false; // The consumer has not read this slot's previous lap yet
+            else
+                position = tail.load(std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Removes the oldest element. Consumer thread only.
+     * @param value Receives the element.
+     * @return True if an element was removed, false if the queue is empty.
+     */
+    bool try_pop(T &value)
+    {
+        Slot &slot = slots[head & mask];
+        if (slot.sequence.load(std::memory_order_acquire) != head + 1)
+            return false;
+
+        value = slot.value;
+        slot.sequence.store(head + mask + 1, std::memory_order_release);
+        head++;
+        return true;
+    }
+
+    /**
+     * @brief Removes up to max_count of the oldest elements. Consumer thread only.
+     * @param out Buffer of at least max_count elements.
+     * @param max_count Maximum number of elements to remove.
+     * @return The number of elements removed.
+     */
+    size_t try_pop_batch(T *out, size_t max_count)
+    {
+        size_t count = 0;
+        while (count < max_count && try_pop(out[count]))
+            count++;
+        return count;
+    }
+
+    /**
+     * @brief Gets the number of elements the queue can hold.
+     * @return The capacity.
+     */
+    size_t capacity() const
+    {
+        return mask + 1;
+    }
+};
+
+#endif // MPSC_QUEUE_H
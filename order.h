@@ -1,6 +1,55 @@
 #ifndef ORDER_H
 #define ORDER_H
 
+#include <cmath>
+#include <cstdint>
+
+/**
+ * @brief Integer price expressed in ticks.
+ *
+ * One tick is 1/10000 of a dollar, which is the native resolution of LOBSTER
+ * prices, so exchange prices map onto ticks exactly.
+ */
+using Price = std::int64_t;
+
+/** Number of ticks per dollar. */
+constexpr Price PRICE_SCALE = 10000;
+
+/**
+ * @brief Converts a tick price to dollars for display.
+ * @param price The price in ticks.
+ * @return The price in dollars.
+ */
+inline double price_to_double(Price price)
+{
+    return static_cast<double>(price) / PRICE_SCALE;
+}
+
+/**
+ * @brief Converts a dollar price to the nearest tick.
+ * @param value The price in dollars.
+ * @return The price in ticks.
+ */
+inline Price price_from_double(double value)
+{
+    return static_cast<Price>(std::llround(value * PRICE_SCALE));
+}
+
+/**
+ * @brief Hints that a cache line will be read or written soon.
+ *
+ * Prefetches never fault, so the address may be stale or unmapped.
+ * @param address Any address in the line.
+ */
+inline void prefetch_memory(const void *address)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(address, 1);
+#else
+    (void)address;
+#endif
+}
+
 /**
  * @enum OrderSide
  * @brief Represents the side of an order in the limit order book.
@@ -26,28 +75,36 @@ enum class OrderType
  * @brief Represents an order in the limit order book.
  *
  * This struct holds the details of an order, including its ID, side, type, price,
- * quantity, and timestamp.
+ * quantity, and timestamp. Resting orders are also nodes of the intrusive FIFO list
+ * of their price level, so they can be unlinked without searching the level.
  */
 struct Order
 {
     int id;              /** Unique identifier for the order. */
     OrderSide side;      /** The side of the order (buy or sell). */
     OrderType type;      /** The type of the order (limit or market). */
-    double price;        /** The price of the order (for limit orders). */
+    Price price;         /** The price of the order in ticks (for limit orders). */
     int quantity;        /** The quantity of the order. */
     long long timestamp; /** The timestamp when the order was created. */
+    Order *prev;         /** The order ahead of this one at its price level. */
+    Order *next;         /** The order behind this one at its price level. */
 
     /**
      * @brief Constructs a new Order instance.
      * @param id The unique identifier for the order.
      * @param side The side of the order (buy or sell).
      * @param type The type of the order (limit or market).
-     * @param price The price of the order (for limit orders).
+     * @param price The price of the order in ticks (for limit orders).
      * @param quantity The quantity of the order.
      * @param timestamp The timestamp when the order was created.
      */
-    Order(int id, OrderSide side, OrderType type, double price,
+    Order(int id, OrderSide side, OrderType type, Price price,
           int quantity, long long timestamp);
+
+    /**
+     * @brief Constructs an empty order, used for unallocated OrderPool slots.
+     */
+    Order();
 };
 
 #endif // ORDER_H
\ No newline at end of file
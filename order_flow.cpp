@@ -0,0 +1,249 @@
+#include "order_flow.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+namespace
+{
+    int side_index(OrderSide side)
+    {
+        return side == OrderSide::BUY ? 0 : 1;
+    }
+
+    void write_lobster_row(std::ostream &out, double timestamp, int type, int order_id,
+                           int quantity, Price price, OrderSide side)
+    {
+        char line[96];
+        int length = std::snprintf(line, sizeof(line), "%.9f,%d,%d,%d,%lld,%d\n", timestamp, type,
+                                   order_id, quantity, static_cast<long long>(price),
+                                   side == OrderSide::BUY ? 1 : -1);
+        out.write(line, length);
+    }
+}
+
+OrderFlowGenerator::OrderFlowGenerator(const OrderFlowConfig &config)
+    : config(config), rng(config.seed), now(config.start_time),
+      mid(static_cast<double>(config.initial_mid) / static_cast<double>(config.tick_size)),
+      excitation(0), next_order_id(1)
+{
+    if (config.arrivals == ArrivalProcess::HAWKES && config.hawkes_alpha >= config.hawkes_beta)
+        throw std::invalid_argument("Hawkes arrivals need hawkes_alpha < hawkes_beta");
+
+    live_index.reserve(2 * config.target_depth);
+}
+
+double OrderFlowGenerator::next_arrival()
+{
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    if (config.arrivals == ArrivalProcess::POISSON)
+        return std::exponential_distribution<double>(config.base_rate)(rng);
+
+    // Ogata thinning: the rate only decays between events, so the current rate bounds it
+    double elapsed = 0;
+    while (true)
+    {
+        double bound = config.base_rate + excitation;
+        double dt = std::exponential_distribution<double>(bound)(rng);
+        elapsed += dt;
+        excitation *= std::exp(-config.hawkes_beta * dt);
+        if (uniform(rng) * bound <= config.base_rate + excitation)
+            break;
+    }
+    excitation += config.hawkes_alpha;
+    return elapsed;
+}
+
+FlowAction OrderFlowGenerator::choose_action(OrderSide side)
+{
+    // Cancels scale with depth relative to the target, pulling each side back towards it
+    double depth = static_cast<double>(live[side_index(side)].size());
+    double cancel = config.cancel_weight * depth / static_cast<double>(config.target_depth > 0 ? config.target_depth : 1);
+    double total = config.add_weight + cancel + config.market_weight;
+
+    double draw = std::uniform_real_distribution<double>(0.0, total)(rng);
+    if (draw < config.add_weight)
+        return FlowAction::ADD;
+    if (draw < config.add_weight + cancel)
+        return FlowAction::CANCEL;
+    return FlowAction::MARKET;
+}
+
+FlowEvent OrderFlowGenerator::next()
+{
+    double dt = next_arrival();
+    now += dt;
+    mid += config.mid_volatility * std::sqrt(dt) * std::normal_distribution<double>(0.0, 1.0)(rng);
+
+    OrderSide side = rng() % 2 ? OrderSide::BUY : OrderSide::SELL;
+    FlowAction action = choose_action(side);
+    std::vector<LiveOrder> &orders = live[side_index(side)];
+    if (action == FlowAction::CANCEL && orders.empty())
+        action = FlowAction::ADD;
+
+    std::geometric_distribution<int> lots(1.0 / (1.0 + config.mean_lots));
+    int quantity = config.lot_size * (1 + lots(rng));
+
+    switch (action)
+    {
+    case FlowAction::ADD:
+    {
+        // Passive side of the mid, at least one grid tick away
+        std::geometric_distribution<int> offset(1.0 / (1.0 + config.mean_level_offset));
+        Price distance = 1 + offset(rng);
+        Price level = side == OrderSide::BUY ? static_cast<Price>(std::floor(mid)) - distance + 1
+                                             : static_cast<Price>(std::ceil(mid)) + distance - 1;
+        if (level < 1)
+            level = 1;
+        return FlowEvent{now, action, side, level * config.tick_size, quantity, next_order_id++};
+    }
+    case FlowAction::CANCEL:
+    {
+        size_t position = static_cast<size_t>(rng() % orders.size());
+        LiveOrder order = orders[position];
+        remove_live(side_index(side), position);
+        return FlowEvent{now, action, side, order.price, order.quantity, order.order_id};
+    }
+    case FlowAction::MARKET:
+    default:
+        return FlowEvent{now, FlowAction::MARKET, side, 0, quantity, 0};
+    }
+}
+
+void OrderFlowGenerator::remove_live(int side, size_t position)
+{
+    std::vector<LiveOrder> &orders = live[side];
+    live_index.erase(orders[position].order_id);
+
+    // Swap-remove; the moved order's position changes
+    if (position + 1 != orders.size())
+    {
+        orders[position] = orders.back();
+        live_index.insert(orders[position].order_id, position);
+    }
+    orders.pop_back();
+}
+
+void OrderFlowGenerator::rest(const FlowEvent &add, int resting_quantity)
+{
+    if (resting_quantity <= 0)
+        return;
+
+    std::vector<LiveOrder> &orders = live[side_index(add.side)];
+    live_index.insert(add.order_id, orders.size());
+    orders.push_back(LiveOrder{add.order_id, add.price, resting_quantity});
+}
+
+bool OrderFlowGenerator::fill(int order_id, int quantity)
+{
+    size_t *position = live_index.find(order_id);
+    if (!position)
+        return true;
+
+    // Fills never say which side they were on; the id is in exactly one side's vector
+    for (int side = 0; side < 2; side++)
+    {
+        std::vector<LiveOrder> &orders = live[side];
+        if (*position < orders.size() && orders[*position].order_id == order_id)
+        {
+            orders[*position].quantity -= quantity;
+            if (orders[*position].quantity > 0)
+                return false;
+            remove_live(side, *position);
+            return true;
+        }
+    }
+    return true;
+}
+
+size_t OrderFlowGenerator::live_orders(OrderSide side) const
+{
+    return live[side_index(side)].size();
+}
+
+OrderFlowStats run_order_flow(OrderFlowGenerator &generator, size_t count, FlowOrderBook &book,
+                              std::ostream *lobster_out)
+{
+    OrderFlowStats stats{};
+    OrderIdIndex<int> book_to_flow; // Internal order id -> flow order id
+    OrderIdIndex<int> flow_to_book; // Flow order id -> internal order id
+    TradeRecorder &recorder = book.get_event_sink();
+    recorder.clear();
+
+    // Reports the trades of the last book call back to the generator; returns the quantity filled
+    auto collect_fills = [&](double timestamp)
+    {
+        int filled = 0;
+        for (const TradeEvent &trade : recorder.get_trades())
+        {
+            filled += trade.quantity;
+            stats.trades++;
+
+            const int *flow_id = book_to_flow.find(trade.passive_order_id);
+            if (!flow_id)
+                continue;
+
+            OrderSide passive_side = trade.aggressor_side == OrderSide::BUY ? OrderSide::SELL : OrderSide::BUY;
+            if (lobster_out)
+                write_lobster_row(*lobster_out, timestamp, 4, *flow_id, trade.quantity, trade.price, passive_side);
+
+            if (generator.fill(*flow_id, trade.quantity))
+            {
+                flow_to_book.erase(*flow_id);
+                book_to_flow.erase(trade.passive_order_id);
+            }
+        }
+        recorder.clear();
+        return filled;
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++)
+    {
+        FlowEvent event = generator.next();
+        if (i == 0)
+            stats.first_timestamp = event.timestamp;
+        stats.last_timestamp = event.timestamp;
+        stats.events++;
+
+        switch (event.action)
+        {
+        case FlowAction::ADD:
+        {
+            int book_id = book.add_limit_order(event.side, event.price, event.quantity);
+            int resting = event.quantity - collect_fills(event.timestamp);
+            generator.rest(event, resting);
+            if (resting > 0)
+            {
+                book_to_flow.insert(book_id, event.order_id);
+                flow_to_book.insert(event.order_id, book_id);
+                if (lobster_out)
+                    write_lobster_row(*lobster_out, event.timestamp, 1, event.order_id, resting, event.price, event.side);
+            }
+            stats.adds++;
+            break;
+        }
+        case FlowAction::CANCEL:
+        {
+            const int *book_id = flow_to_book.find(event.order_id);
+            if (book_id && book.cancel_order(*book_id))
+            {
+                book_to_flow.erase(*book_id);
+                flow_to_book.erase(event.order_id);
+                if (lobster_out)
+                    write_lobster_row(*lobster_out, event.timestamp, 3, event.order_id, event.quantity, event.price, event.side);
+                stats.cancels++;
+            }
+            break;
+        }
+        case FlowAction::MARKET:
+            book.add_market_order(event.side, event.quantity);
+            collect_fills(event.timestamp);
+            stats.markets++;
+            break;
+        }
+    }
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
@@ -0,0 +1,197 @@
+#ifndef ORDER_FLOW_H
+#define ORDER_FLOW_H
+
+#include "lob.h"
+#include "order.h"
+#include "order_id_index.h"
+#include <cstddef>
+#include <ostream>
+#include <random>
+#include <vector>
+
+/**
+ * @enum ArrivalProcess
+ * @brief Point process that times synthetic order flow events.
+ */
+enum class ArrivalProcess
+{
+    POISSON, /** Independent arrivals at a constant rate. */
+    HAWKES   /** Self-exciting arrivals: every event briefly raises the rate. */
+};
+
+/**
+ * @enum FlowAction
+ * @brief What a synthetic order flow event does to the book.
+ */
+enum class FlowAction
+{
+    ADD,    /** Submit a limit order. */
+    CANCEL, /** Cancel a resting order. */
+    MARKET  /** Submit a market order. */
+};
+
+/**
+ * @struct OrderFlowConfig
+ * @brief Parameters of the synthetic order flow generator.
+ */
+struct OrderFlowConfig
+{
+    unsigned long long seed = 1;                       // Random seed; equal seeds give equal flows
+    ArrivalProcess arrivals = ArrivalProcess::POISSON; // Arrival process of events
+    double base_rate = 10000;                          // Events per second (baseline rate for Hawkes)
+    double hawkes_alpha = 6000;                        // Rate jump per event (Hawkes)
+    double hawkes_beta = 10000;                        // Decay of the jump per second (Hawkes); must exceed alpha
+
+    double add_weight = 0.55;                          // Relative frequency of limit orders
+    double cancel_weight = 0.40;                       // Relative frequency of cancels at the target depth
+    double market_weight = 0.05;                       // Relative frequency of market orders
+
+    size_t target_depth = 1000;                        // Resting orders per side the flow gravitates to
+    Price initial_mid = 5850000;                       // Starting mid price in ticks
+    Price tick_size = 100;                             // Price grid in ticks
+    double mid_volatility = 2.0;                       // Mid drift in grid ticks per sqrt(second)
+    double mean_level_offset = 5.0;                    // Mean distance of new limit orders from the mid, in grid ticks
+    int lot_size = 100;                                // Shares per lot
+    double mean_lots = 2.0;                            // Mean order size in lots
+    double start_time = 34200.0;                       // Timestamp of the first event (09:30)
+};
+
+/**
+ * @struct FlowEvent
+ * @brief One generated order flow event.
+ */
+struct FlowEvent
+{
+    double timestamp;  // Seconds after midnight
+    FlowAction action; // What the event does
+    OrderSide side;    // Side of the order (for markets, the aggressor side)
+    Price price;       // Limit price in ticks (0 for market orders)
+    int quantity;      // Order quantity (remaining quantity for cancels)
+    int order_id;      // Flow order id for adds and cancels, 0 for market orders
+};
+
+/**
+ * @class OrderFlowGenerator
+ * @brief Deterministic, seeded generator of synthetic order flow.
+ *
+ * Limit prices are drawn around a mid price that follows a random walk, with the
+ * distance from the mid geometrically distributed. Cancels pick a random resting order
+ * and become more likely the further a side's depth exceeds the target, so the book
+ * settles around target_depth orders per side.
+ *
+ * The generator tracks which of its orders are resting, so the caller must report how
+ * much of each add rested (rest) and every fill against a resting order (fill).
+ */
+class OrderFlowGenerator
+{
+private:
+    struct LiveOrder
+    {
+        int order_id;
+        Price price;
+        int quantity;
+    };
+
+    OrderFlowConfig config;
+    std::mt19937_64 rng;
+    double now;        // Timestamp of the last event
+    double mid;        // Mid price in grid ticks
+    double excitation; // Hawkes rate above the baseline
+    int next_order_id;
+
+    // Resting orders per side (index 0 = buy, 1 = sell), and order id -> position
+    std::vector<LiveOrder> live[2];
+    OrderIdIndex<size_t> live_index;
+
+    /**
+     * @brief Advances the clock to the next arrival of the configured process.
+     * @return Seconds since the previous event.
+     */
+    double next_arrival();
+
+    /**
+     * @brief Draws an action for a side, weighted by how far its depth is from the target.
+     * @param side The side the event applies to.
+     * @return The chosen action.
+     */
+    FlowAction choose_action(OrderSide side);
+
+    /**
+     * @brief Removes a resting order from the live set.
+     * @param side Side of the order.
+     * @param position Position of the order in its side's live vector.
+     */
+    void remove_live(int side, size_t position);
+
+public:
+    /**
+     * @brief Constructs a generator.
+     * @param config The flow parameters.
+     * @throws std::invalid_argument if the Hawkes process would be explosive.
+     */
+    explicit OrderFlowGenerator(const OrderFlowConfig &config = OrderFlowConfig());
+
+    /**
+     * @brief Generates the next event. A cancelled order leaves the live set at once.
+     * @return The event.
+     */
+    FlowEvent next();
+
+    /**
+     * @brief Records how much of an add rested in the book after matching.
+     * @param add The ADD event.
+     * @param resting_quantity Quantity left resting (0 if the order filled completely).
+     */
+    void rest(const FlowEvent &add, int resting_quantity);
+
+    /**
+     * @brief Records a fill against a resting order.
+     * @param order_id Flow id of the resting order.
+     * @param quantity Quantity filled.
+     * @return True if the order is now completely filled.
+     */
+    bool fill(int order_id, int quantity);
+
+    /**
+     * @brief Gets the number of resting orders on a side.
+     * @param side The side.
+     * @return The number of live orders.
+     */
+    size_t live_orders(OrderSide side) const;
+};
+
+/** Book that synthetic flow is driven into; it records trades so fills can be reported back. */
+using FlowOrderBook = BasicLimitOrderBook<DefaultPriceLevels, TradeRecorder>;
+
+/**
+ * @struct OrderFlowStats
+ * @brief Summary of a run_order_flow call.
+ */
+struct OrderFlowStats
+{
+    size_t events;          // Events generated
+    size_t adds;            // Limit orders submitted
+    size_t cancels;         // Orders cancelled
+    size_t markets;         // Market orders submitted
+    size_t trades;          // Trades produced by the book
+    double seconds;         // Wall-clock time of the run
+    double first_timestamp; // Timestamp of the first event
+    double last_timestamp;  // Timestamp of the last event
+};
+
+/**
+ * @brief Drives generated events into a book and optionally writes them as LOBSTER messages.
+ *
+ * Adds are written as new orders (type 1) with the quantity that rested, cancels as
+ * deletions (type 3), and every fill as an execution (type 4) of the resting order, so
+ * the file describes exactly the book the events produced.
+ * @param generator The event source.
+ * @param count Number of events to generate.
+ * @param book The book to drive.
+ * @param lobster_out Stream to write LOBSTER message rows to, or nullptr.
+ * @return Counts and timing of the run.
+ */
+OrderFlowStats run_order_flow(OrderFlowGenerator &generator, size_t count, FlowOrderBook &book,
+                              std::ostream *lobster_out);
+
+#endif // ORDER_FLOW_H
@@ -0,0 +1,210 @@
+#include "order_gateway.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+OrderGateway::OrderGateway(size_t queue_capacity)
+    : requests(queue_capacity), stopping(false), running(false), processed_requests(0), parked_responses(0),
+      dropped_responses(0), drained_batches(0), largest_batch(0), busy_seconds(0) {}
+
+OrderGateway::~OrderGateway()
+{
+    stop();
+}
+
+int OrderGateway::add_client(size_t response_capacity)
+{
+    clients.push_back(std::make_unique<Client>(response_capacity));
+    return static_cast<int>(clients.size() - 1);
+}
+
+void OrderGateway::deliver(uint32_t client_id, const GatewayResponse &response)
+{
+    Client &client = *clients[client_id];
+    if (client.parked.empty() && client.ring.try_push(response))
+        return;
+
+    // Waiting here would stall every other client; keep it, in order, for later
+    if (client.parked.empty())
+    {
+        backed_up_clients.push_back(client_id);
+        client.backed_up.store(true, std::memory_order_release);
+    }
+    client.parked.push_back(response);
+    parked_responses++;
+}
+
+void OrderGateway::flush_parked()
+{
+    for (size_t i = 0; i < backed_up_clients.size();)
+    {
+        Client &client = *clients[backed_up_clients[i]];
+        while (!client.parked.empty() && client.ring.try_push(client.parked.front()))
+            client.parked.pop_front();
+
+        if (client.parked.empty())
+        {
+            client.backed_up.store(false, std::memory_order_release);
+            backed_up_clients[i] = backed_up_clients.back();
+            backed_up_clients.pop_back();
+        }
+        else
+            i++;
+    }
+}
+
+void OrderGateway::run()
+{
+    auto run_start = std::chrono::steady_clock::now();
+
+    std::vector<GatewayRequest> drained(DRAIN_BATCH);
+    std::vector<BookCommand> commands(DRAIN_BATCH);
+    std::vector<int> results(DRAIN_BATCH);
+
+    while (true)
+    {
+        if (!backed_up_clients.empty())
+            flush_parked();
+
+        size_t count = requests.try_pop_batch(drained.data(), DRAIN_BATCH);
+        if (count == 0)
+        {
+            // Every try_submit that returned before stop() is visible once stopping is
+            if (!stopping.load(std::memory_order_acquire))
+            {
+                cpu_relax();
+                continue;
+            }
+            count = requests.try_pop_batch(drained.data(), DRAIN_BATCH);
+            if (count == 0)
+                break;
+        }
+
+        for (size_t i = 0; i < count; i++)
+            commands[i] = drained[i].command;
+        book.process_batch(commands.data(), count, results.data());
+
+        for (size_t i = 0; i < count; i++)
+        {
+            const GatewayRequest &request = drained[i];
+            deliver(request.client_id, GatewayResponse{request.tag, results[i], request.command.type});
+        }
+
+        processed_requests += count;
+        drained_batches++;
+        largest_batch = std::max(largest_batch, count);
+    }
+
+    // Nobody may be reading any more; shutting down must not wait on a client
+    flush_parked();
+    for (uint32_t client_id : backed_up_clients)
+    {
+        Client &client = *clients[client_id];
+        dropped_responses += client.parked.size();
+        client.parked.clear();
+        client.backed_up.store(false, std::memory_order_release);
+    }
+    backed_up_clients.clear();
+
+    busy_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - run_start).count();
+}
+
+void OrderGateway::start()
+{
+    if (running)
+        return;
+
+    running = true;
+    stopping.store(false, std::memory_order_relaxed);
+    matcher = std::thread(&OrderGateway::run, this);
+}
+
+void OrderGateway::stop()
+{
+    if (!running)
+        return;
+
+    stopping.store(true, std::memory_order_release);
+    matcher.join();
+    running = false;
+}
+
+bool OrderGateway::is_valid_command(const BookCommand &command)
+{
+    bool valid_side = command.side == OrderSide::BUY || command.side == OrderSide::SELL;
+    switch (command.type)
+    {
+    case BookCommandType::LIMIT:
+        return valid_side && command.quantity > 0 && command.price > 0;
+    case BookCommandType::MARKET:
+        return valid_side && command.quantity > 0;
+    case BookCommandType::CANCEL:
+        return command.order_id > 0;
+    case BookCommandType::REDUCE:
+        return command.order_id > 0 && command.quantity > 0;
+    default:
+        // INSERT and FILL replay exchange history; they are not client operations
+        return false;
+    }
+}
+
+SubmitResult OrderGateway::try_submit(int client_id, uint64_t tag, const BookCommand &command)
+{
+    if (client_id < 0 || static_cast<size_t>(client_id) >= clients.size() || !is_valid_command(command))
+        return SubmitResult::REJECTED;
+
+    // Back-pressure on the one client that stopped reading, not on the queue everyone shares
+    if (clients[client_id]->backed_up.load(std::memory_order_acquire))
+        return SubmitResult::FULL;
+
+    bool queued = requests.try_push(GatewayRequest{tag, static_cast<uint32_t>(client_id), command});
+    return queued ? SubmitResult::QUEUED : SubmitResult::FULL;
+}
+
+bool OrderGateway::try_receive(int client_id, GatewayResponse &response)
+{
+    if (client_id < 0 || static_cast<size_t>(client_id) >= clients.size())
+        return false;
+    return clients[client_id]->ring.try_pop(response);
+}
+
+size_t OrderGateway::client_count() const
+{
+    return clients.size();
+}
+
+uint64_t OrderGateway::get_dropped_responses() const
+{
+    return dropped_responses;
+}
+
+const LimitOrderBook &OrderGateway::get_book() const
+{
+    return book;
+}
+
+void OrderGateway::print_statistics() const
+{
+    std::cout << "\n=== ORDER GATEWAY STATISTICS ===" << std::endl;
+    std::cout << "Clients: " << clients.size() << std::endl;
+    std::cout << "Requests Processed: " << processed_requests << std::endl;
+    if (parked_responses > 0)
+        std::cout << "Responses Parked On A Full Ring: " << parked_responses << std::endl;
+    if (dropped_responses > 0)
+        std::cout << "Responses Dropped At Shutdown: " << dropped_responses << std::endl;
+    if (drained_batches > 0)
+    {
+        std::cout << "Batches: " << drained_batches << " (avg " << std::fixed << std::setprecision(1)
+                  << static_cast<double>(processed_requests) / drained_batches
+                  << ", max " << largest_batch << " requests)" << std::endl;
+    }
+    if (busy_seconds > 0)
+    {
+        std::cout << "Throughput: " << std::fixed << std::setprecision(0)
+                  << processed_requests / busy_seconds << " requests/s ("
+                  << std::setprecision(3) << busy_seconds << "s matching thread)" << std::endl;
+    }
+    std::cout << "Active Orders: " << book.get_order_pool().size() << std::endl;
+    std::cout << "================================" << std::endl;
+}
@@ -0,0 +1,209 @@
+#ifndef ORDER_GATEWAY_H
+#define ORDER_GATEWAY_H
+
+#include "lob.h"
+#include "mpsc_queue.h"
+#include "spsc_ring.h"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/**
+ * @struct GatewayRequest
+ * @brief A command submitted by one gateway client.
+ */
+struct GatewayRequest
+{
+    uint64_t tag;        // Caller-chosen value echoed in the response
+    uint32_t client_id;  // Client whose response ring receives the result
+    BookCommand command; // Operation to apply
+};
+
+/**
+ * @struct GatewayResponse
+ * @brief The outcome of one GatewayRequest, delivered to the submitting client.
+ */
+struct GatewayResponse
+{
+    uint64_t tag;         // The request's tag
+    int result;           // process_batch result for the command (see BookCommandType)
+    BookCommandType type; // The request's command type
+};
+
+/**
+ * @enum SubmitResult
+ * @brief Outcome of OrderGateway::try_submit.
+ */
+enum class SubmitResult
+{
+    QUEUED,  /** The command was queued; exactly one response will follow */
+    FULL,    /** The ingress queue is full or the client's responses are backed up; nothing was queued, retry later */
+    REJECTED /** Unknown client or invalid command; nothing was queued and no response follows */
+};
+
+/**
+ * @class OrderGateway
+ * @brief Lock-free ingress in front of a single matching thread.
+ *
+ * Any number of client threads submit commands into one bounded MPSC queue; the
+ * matching thread owns the book, drains the queue in batches through process_batch
+ * and answers each request on its client's SPSC response ring, in submission order
+ * per client. The matching thread busy-polls, so it keeps one core for itself while
+ * running.
+ *
+ * Clients may send limit, market, cancel and reduce commands; anything else, and any
+ * command with a bad side, price, quantity or order id, is rejected before it reaches
+ * the queue. Clients must be added before start(), and each client id must be used by
+ * one thread at a time. Responses that find a client's ring full are parked for that
+ * client alone, so the matching thread keeps serving everyone else; until its parked
+ * responses fit into the ring again, the client's submissions return FULL. Clients
+ * should therefore keep draining responses while they submit.
+ */
+class OrderGateway
+{
+public:
+    /** Default number of requests buffered between the clients and the matching thread. */
+    static constexpr size_t DEFAULT_QUEUE_CAPACITY = 1 << 16;
+
+    /** Default number of responses buffered per client. */
+    static constexpr size_t DEFAULT_RESPONSE_CAPACITY = 1 << 14;
+
+    /** Maximum number of requests the matching thread hands to process_batch at once. */
+    static constexpr size_t DRAIN_BATCH = 256;
+
+private:
+    /**
+     * @struct Client
+     * @brief Response path of one client.
+     */
+    struct Client
+    {
+        SpscRing<GatewayResponse> ring;     // Responses the client has yet to read
+        std::deque<GatewayResponse> parked; // Responses that did not fit the ring, oldest first; matching thread only
+        std::atomic<bool> backed_up;        // True while parked is non-empty
+
+        explicit Client(size_t capacity) : ring(capacity), backed_up(false) {}
+    };
+
+    LimitOrderBook book;                          // Touched only by the matching thread while running
+    MpscQueue<GatewayRequest> requests;           // Ingress shared by every client
+    std::vector<std::unique_ptr<Client>> clients; // Indexed by client id
+    std::vector<uint32_t> backed_up_clients;      // Clients with parked responses; matching thread only
+    std::thread matcher;
+    std::atomic<bool> stopping;
+    bool running;
+
+    // Matching thread statistics, valid after stop()
+    uint64_t processed_requests;
+    uint64_t parked_responses;  // Responses that waited for room in their client's ring
+    uint64_t dropped_responses; // Responses still parked when the matching thread stopped
+    uint64_t drained_batches;
+    size_t largest_batch;
+    double busy_seconds;
+
+    /**
+     * @brief Matching loop: drains and applies requests until stop() is called and the queue is empty.
+     */
+    void run();
+
+    /**
+     * @brief Hands a response to its client's ring, or parks it behind the client's earlier responses.
+     * @param client_id The client to answer.
+     * @param response The response.
+     */
+    void deliver(uint32_t client_id, const GatewayResponse &response);
+
+    /**
+     * @brief Moves parked responses into rings that have room again.
+     */
+    void flush_parked();
+
+    /**
+     * @brief Checks a command at the boundary, before it can reach the book.
+     * @param command The command a client submitted.
+     * @return True if it is a client operation with a valid side, price, quantity and order id.
+     */
+    static bool is_valid_command(const BookCommand &command);
+
+public:
+    /**
+     * @brief Constructs a stopped gateway with an empty book.
+     * @param queue_capacity Minimum number of requests the ingress queue holds.
+     */
+    explicit OrderGateway(size_t queue_capacity = DEFAULT_QUEUE_CAPACITY);
+
+    /**
+     * @brief Stops the matching thread if it is still running.
+     */
+    ~OrderGateway();
+
+    OrderGateway(const OrderGateway &) = delete;
+    OrderGateway &operator=(const OrderGateway &) = delete;
+
+    /**
+     * @brief Registers a client. Only before start().
+     * @param response_capacity Minimum number of responses buffered for the client.
+     * @return The client's id.
+     */
+    int add_client(size_t response_capacity = DEFAULT_RESPONSE_CAPACITY);
+
+    /**
+     * @brief Starts the matching thread.
+     */
+    void start();
+
+    /**
+     * @brief Applies every request already submitted, then stops the matching thread.
+     *
+     * Call once clients have stopped submitting; requests submitted afterwards are not
+     * applied. Never waits on a client: responses still parked for a full ring when the
+     * last request is applied are dropped and counted.
+     */
+    void stop();
+
+    /**
+     * @brief Submits a command without blocking. Client thread only.
+     * @param client_id The id returned by add_client.
+     * @param tag Value echoed in the response.
+     * @param command The command to apply.
+     * @return QUEUED, FULL if the ingress queue has no room or this client's responses
+     *         are parked (read some with try_receive, then retry), or REJECTED.
+     */
+    SubmitResult try_submit(int client_id, uint64_t tag, const BookCommand &command);
+
+    /**
+     * @brief Takes the client's oldest unread response without blocking. Client thread only.
+     * @param client_id The id returned by add_client.
+     * @param response Receives the response.
+     * @return True if a response was read, false if none is ready or the client id is unknown.
+     */
+    bool try_receive(int client_id, GatewayResponse &response);
+
+    /**
+     * @brief Gets the number of registered clients.
+     * @return The client count.
+     */
+    size_t client_count() const;
+
+    /**
+     * @brief Gets the number of responses dropped because their ring was still full at shutdown.
+     * @return The dropped response count, valid after stop().
+     */
+    uint64_t get_dropped_responses() const;
+
+    /**
+     * @brief Gets the book. Only while the gateway is stopped.
+     * @return The book the matching thread applies requests to.
+     */
+    const LimitOrderBook &get_book() const;
+
+    /**
+     * @brief Prints matching thread throughput and batching statistics.
+     */
+    void print_statistics() const;
+};
+
+#endif // ORDER_GATEWAY_H
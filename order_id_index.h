@@ -0,0 +1,333 @@
+#ifndef ORDER_ID_INDEX_H
+#define ORDER_ID_INDEX_H
+
+#include "order.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * @enum IdIndexMode
+ * @brief Storage strategy of an OrderIdIndex.
+ */
+enum class IdIndexMode
+{
+    HASHED, /** Open-addressing hash table; works for any ids. */
+    DENSE   /** Vector indexed directly by id; for compact, non-negative ids. */
+};
+
+/**
+ * @class OrderIdIndex
+ * @brief Flat map from integer order ids to a small value (usually an order handle).
+ *
+ * In HASHED mode entries live inline in one power-of-two array using robin-hood
+ * linear probing with backward-shift deletion, so a lookup touches one or two
+ * adjacent cache lines instead of chasing a node pointer. In DENSE mode the id is
+ * the array index, which is the cheapest option when ids are known to be compact.
+ *
+ * @tparam Value The mapped type. Must be default constructible and copyable.
+ */
+template <typename Value>
+class OrderIdIndex
+{
+private:
+    struct Slot
+    {
+        int key;       // Order id
+        uint32_t dist; // Probe distance + 1; 0 marks an empty slot
+        Value value;   // Mapped value
+    };
+
+    // Keep probe sequences short: grow past 80% occupancy
+    static constexpr size_t MAX_LOAD_PERCENT = 80;
+    static constexpr size_t MIN_CAPACITY = 16;
+
+    IdIndexMode mode;
+    size_t count;
+
+    // HASHED storage
+    std::vector<Slot> slots;
+    size_t mask;
+
+    // DENSE storage
+    std::vector<Value> dense_values;
+    std::vector<uint8_t> dense_present;
+
+    size_t home_slot(int key) const
+    {
+        // Fibonacci hashing spreads sequential ids across the table
+        uint64_t h = static_cast<uint64_t>(static_cast<uint32_t>(key)) * 11400714819323198485ull;
+        return static_cast<size_t>(h >> 32) & mask;
+    }
+
+    size_t find_slot(int key) const
+    {
+        if (slots.empty())
+            return SIZE_MAX;
+
+        size_t i = home_slot(key);
+        for (uint32_t dist = 1;; dist++)
+        {
+            const Slot &slot = slots[i];
+            // Robin-hood invariant: once we pass a richer slot the key cannot be further on
+            if (slot.dist < dist)
+                return SIZE_MAX;
+            if (slot.key == key)
+                return i;
+            i = (i + 1) & mask;
+        }
+    }
+
+    void place(int key, const Value &value)
+    {
+        Slot carry{key, 1, value};
+        size_t i = home_slot(key);
+        while (true)
+        {
+            Slot &slot = slots[i];
+            if (slot.dist == 0)
+            {
+                slot = carry;
+                return;
+            }
+            // Steal from the rich: the entry closer to home moves on
+            if (slot.dist < carry.dist)
+                std::swap(slot, carry);
+            i = (i + 1) & mask;
+            carry.dist++;
+        }
+    }
+
+    void rehash(size_t new_capacity)
+    {
+        std::vector<Slot> old = std::move(slots);
+        slots.assign(new_capacity, Slot{0, 0, Value()});
+        mask = new_capacity - 1;
+        for (const Slot &slot : old)
+        {
+            if (slot.dist != 0)
+                place(slot.key, slot.value);
+        }
+    }
+
+    static size_t capacity_for(size_t n)
+    {
+        size_t needed = n * 100 / MAX_LOAD_PERCENT + 1;
+        size_t capacity = MIN_CAPACITY;
+        while (capacity < needed)
+            capacity <<= 1;
+        return capacity;
+    }
+
+public:
+    /**
+     * @brief Constructs an empty index.
+     * @param mode The storage strategy.
+     */
+    explicit OrderIdIndex(IdIndexMode mode = IdIndexMode::HASHED)
+        : mode(mode), count(0), mask(0) {}
+
+    /**
+     * @brief Clears the index and switches its storage strategy.
+     * @param new_mode The storage strategy.
+     * @param expected_ids Number of ids (HASHED) or largest id (DENSE) to pre-size for.
+     */
+    void configure(IdIndexMode new_mode, size_t expected_ids)
+    {
+        mode = new_mode;
+        count = 0;
+        slots.clear();
+        mask = 0;
+        dense_values.clear();
+        dense_present.clear();
+        reserve(expected_ids);
+    }
+
+    /**
+     * @brief Pre-sizes the index so it does not grow while holding n ids.
+     * @param n Number of ids (HASHED) or largest id (DENSE) to make room for.
+     */
+    void reserve(size_t n)
+    {
+        if (mode == IdIndexMode::DENSE)
+        {
+            if (n + 1 > dense_values.size())
+            {
+                dense_values.resize(n + 1);
+                dense_present.resize(n + 1, 0);
+            }
+        }
+        else if (capacity_for(n) > slots.size())
+            rehash(capacity_for(n));
+    }
+
+    /**
+     * @brief Looks up an id.
+     * @param key The order id.
+     * @return A pointer to the mapped value, or nullptr if the id is not present.
+     */
+    Value *find(int key)
+    {
+        if (mode == IdIndexMode::DENSE)
+        {
+            size_t i = static_cast<size_t>(key);
+            if (key < 0 || i >= dense_present.size() || !dense_present[i])
+                return nullptr;
+            return &dense_values[i];
+        }
+
+        size_t i = find_slot(key);
+        return i == SIZE_MAX ? nullptr : &slots[i].value;
+    }
+
+    /**
+     * @brief Looks up an id.
+     * @param key The order id.
+     * @return A pointer to the mapped value, or nullptr if the id is not present.
+     */
+    const Value *find(int key) const
+    {
+        return const_cast<OrderIdIndex *>(this)->find(key);
+    }
+
+    /**
+     * @brief Starts loading the slot an id's lookup will read first.
+     * @param key The order id.
+     */
+    void prefetch(int key) const
+    {
+        if (mode == IdIndexMode::DENSE)
+        {
+            size_t i = static_cast<size_t>(key);
+            if (key >= 0 && i < dense_values.size())
+                prefetch_memory(&dense_values[i]);
+        }
+        else if (!slots.empty())
+            prefetch_memory(&slots[home_slot(key)]);
+    }
+
+    /**
+     * @brief Inserts an id or overwrites its value.
+     * @param key The order id. Must be non-negative in DENSE mode.
+     * @param value The value to map it to.
+     */
+    void insert(int key, const Value &value)
+    {
+        if (mode == IdIndexMode::DENSE)
+        {
+            size_t i = static_cast<size_t>(key);
+            if (i >= dense_values.size())
+                reserve(std::max(i, dense_values.size() * 2));
+            if (!dense_present[i])
+                count++;
+            dense_values[i] = value;
+            dense_present[i] = 1;
+            return;
+        }
+
+        size_t i = find_slot(key);
+        if (i != SIZE_MAX)
+        {
+            slots[i].value = value;
+            return;
+        }
+
+        if ((count + 1) * 100 > slots.size() * MAX_LOAD_PERCENT)
+            rehash(slots.empty() ? MIN_CAPACITY : slots.size() * 2);
+
+        place(key, value);
+        count++;
+    }
+
+    /**
+     * @brief Removes an id.
+     * @param key The order id.
+     * @return True if the id was present, false otherwise.
+     */
+    bool erase(int key)
+    {
+        if (mode == IdIndexMode::DENSE)
+        {
+            size_t i = static_cast<size_t>(key);
+            if (key < 0 || i >= dense_present.size() || !dense_present[i])
+                return false;
+            dense_present[i] = 0;
+            count--;
+            return true;
+        }
+
+        size_t i = find_slot(key);
+        if (i == SIZE_MAX)
+            return false;
+
+        // Backward-shift the following cluster instead of leaving a tombstone
+        size_t next = (i + 1) & mask;
+        while (slots[next].dist > 1)
+        {
+            slots[i] = slots[next];
+            slots[i].dist--;
+            i = next;
+            next = (next + 1) & mask;
+        }
+        slots[i].dist = 0;
+        count--;
+        return true;
+    }
+
+    /**
+     * @brief Calls a function for every (id, value) pair, in no particular order.
+     * @param visit Callable taking (int id, const Value &value).
+     */
+    template <typename Visitor>
+    void for_each(Visitor visit) const
+    {
+        if (mode == IdIndexMode::DENSE)
+        {
+            for (size_t i = 0; i < dense_present.size(); i++)
+            {
+                if (dense_present[i])
+                    visit(static_cast<int>(i), dense_values[i]);
+            }
+            return;
+        }
+
+        for (const Slot &slot : slots)
+        {
+            if (slot.dist != 0)
+                visit(slot.key, slot.value);
+        }
+    }
+
+    /**
+     * @brief Removes all ids, keeping the allocated storage.
+     */
+    void clear()
+    {
+        for (Slot &slot : slots)
+            slot.dist = 0;
+        std::fill(dense_present.begin(), dense_present.end(), 0);
+        count = 0;
+    }
+
+    /**
+     * @brief Gets the number of ids in the index.
+     * @return The number of ids.
+     */
+    size_t size() const
+    {
+        return count;
+    }
+
+    /**
+     * @brief Gets the storage strategy.
+     * @return The index mode.
+     */
+    IdIndexMode get_mode() const
+    {
+        return mode;
+    }
+};
+
+#endif // ORDER_ID_INDEX_H
@@ -0,0 +1,93 @@
+#include "order_pool.h"
+#include <iostream>
+#include <utility>
+
+OrderPool::OrderPool() : free_list(nullptr), in_use(0), high_water_mark(0) {}
+
+OrderPool::OrderPool(OrderPool &&other) noexcept
+    : slabs(std::move(other.slabs)),
+      free_list(std::exchange(other.free_list, nullptr)),
+      in_use(std::exchange(other.in_use, 0)),
+      high_water_mark(std::exchange(other.high_water_mark, 0)) {}
+
+OrderPool &OrderPool::operator=(OrderPool &&other) noexcept
+{
+    if (this != &other)
+    {
+        slabs = std::move(other.slabs);
+        other.slabs.clear();
+        free_list = std::exchange(other.free_list, nullptr);
+        in_use = std::exchange(other.in_use, 0);
+        high_water_mark = std::exchange(other.high_water_mark, 0);
+    }
+    return *this;
+}
+
+void OrderPool::grow()
+{
+    slabs.emplace_back(new Order[SLAB_SIZE]);
+    Order *slab = slabs.back().get();
+
+    // Thread the new slab onto the free list so the lowest address is handed out first
+    for (size_t i = SLAB_SIZE; i-- > 0;)
+    {
+        slab[i].next = free_list;
+        free_list = &slab[i];
+    }
+}
+
+Order *OrderPool::allocate(const Order &order)
+{
+    if (!free_list)
+        grow();
+
+    Order *slot = free_list;
+    free_list = slot->next;
+
+    *slot = order;
+    slot->prev = nullptr;
+    slot->next = nullptr;
+
+    in_use++;
+    if (in_use > high_water_mark)
+        high_water_mark = in_use;
+
+    return slot;
+}
+
+void OrderPool::release(Order *order)
+{
+    order->prev = nullptr;
+    order->next = free_list;
+    free_list = order;
+    in_use--;
+}
+
+void OrderPool::reserve(size_t n)
+{
+    // Orders already handed out do not count towards the reservation
+    while (capacity() - in_use < n)
+        grow();
+}
+
+size_t OrderPool::size() const
+{
+    return in_use;
+}
+
+size_t OrderPool::capacity() const
+{
+    return slabs.size() * SLAB_SIZE;
+}
+
+size_t OrderPool::get_high_water_mark() const
+{
+    return high_water_mark;
+}
+
+void OrderPool::print_stats() const
+{
+    std::cout << "Order Pool: " << in_use << " live, "
+              << high_water_mark << " high-water mark, "
+              << capacity() << " capacity (" << slabs.size() << " slabs)" << std::endl;
+}
@@ -0,0 +1,93 @@
+#ifndef ORDER_POOL_H
+#define ORDER_POOL_H
+
+#include "order.h"
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/**
+ * @class OrderPool
+ * @brief Slab allocator for resting orders.
+ *
+ * Orders are carved out of fixed-size slabs that are never moved or freed while the
+ * pool lives, so an Order pointer handed out by the pool is a stable, non-refcounted
+ * handle. Released orders go onto an intrusive free list (threaded through
+ * Order::next) and are reused before any new slab is allocated.
+ */
+class OrderPool
+{
+public:
+    /** Number of orders allocated per slab. */
+    static constexpr size_t SLAB_SIZE = 4096;
+
+private:
+    // Slabs of order storage, in allocation order
+    std::vector<std::unique_ptr<Order[]>> slabs;
+
+    // Head of the free list of released orders
+    Order *free_list;
+
+    size_t in_use;          // Orders currently handed out
+    size_t high_water_mark; // Largest value in_use has reached
+
+    /**
+     * @brief Allocates one more slab and pushes its orders onto the free list.
+     */
+    void grow();
+
+public:
+    /**
+     * @brief Constructs an empty pool; slabs are allocated on first use.
+     */
+    OrderPool();
+
+    OrderPool(const OrderPool &) = delete;
+    OrderPool &operator=(const OrderPool &) = delete;
+    OrderPool(OrderPool &&other) noexcept;
+    OrderPool &operator=(OrderPool &&other) noexcept;
+
+    /**
+     * @brief Takes an order slot from the pool and copies an order into it.
+     * @param order The order to store.
+     * @return A stable pointer to the pooled order.
+     */
+    Order *allocate(const Order &order);
+
+    /**
+     * @brief Returns an order slot to the pool for reuse.
+     * @param order The order to release. It must have come from this pool.
+     */
+    void release(Order *order);
+
+    /**
+     * @brief Ensures the pool can hand out at least n more orders without allocating.
+     * @param n The number of orders to reserve room for, on top of those already live.
+     */
+    void reserve(size_t n);
+
+    /**
+     * @brief Gets the number of orders currently handed out.
+     * @return The number of live orders.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Gets the total number of order slots allocated.
+     * @return The pool capacity.
+     */
+    size_t capacity() const;
+
+    /**
+     * @brief Gets the largest number of orders that were live at the same time.
+     * @return The high-water mark.
+     */
+    size_t get_high_water_mark() const;
+
+    /**
+     * @brief Prints pool usage statistics.
+     */
+    void print_stats() const;
+};
+
+#endif // ORDER_POOL_H
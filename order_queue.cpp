@@ -1,32 +1,36 @@
 #include "order_queue.h"
 
-OrderQueue::OrderQueue() : total_quantity(0) {}
+OrderQueue::OrderQueue() : head(nullptr), tail(nullptr), total_quantity(0), order_count(0) {}
 
-void OrderQueue::add_order(std::shared_ptr<Order> order)
+void OrderQueue::add_order(Order *order)
 {
-    orders.push(order);
+    order->prev = tail;
+    order->next = nullptr;
+
+    if (tail)
+        tail->next = order;
+    else
+        head = order;
+
+    tail = order;
     total_quantity += order->quantity;
+    order_count++;
 }
 
-std::shared_ptr<Order> OrderQueue::front()
+Order *OrderQueue::front() const
 {
-    if (orders.empty())
-        return nullptr;
-    return orders.front();
+    return head;
 }
 
 void OrderQueue::pop()
 {
-    if (!orders.empty())
-    {
-        total_quantity -= orders.front()->quantity;
-        orders.pop();
-    }
+    if (head)
+        remove_order(head);
 }
 
 bool OrderQueue::empty() const
 {
-    return orders.empty();
+    return head == nullptr;
 }
 
 int OrderQueue::get_total_quantity() const
@@ -34,37 +38,52 @@ int OrderQueue::get_total_quantity() const
     return total_quantity;
 }
 
+size_t OrderQueue::size() const
+{
+    return order_count;
+}
+
 void OrderQueue::update_quantity(int new_quantity)
 {
-    if (!orders.empty())
+    if (head)
     {
-        int old_quantity = orders.front()->quantity;
-        orders.front()->quantity = new_quantity;
+        int old_quantity = head->quantity;
+        head->quantity = new_quantity;
         total_quantity = total_quantity - old_quantity + new_quantity;
     }
 }
 
-bool OrderQueue::remove_order(int order_id)
+bool OrderQueue::reduce_order(Order *order, int quantity)
 {
-    std::queue<std::shared_ptr<Order>> temp_queue;
-    bool found = false;
+    // A non-positive quantity would grow the order and the level total
+    if (quantity <= 0 || quantity >= order->quantity)
+        return false;
 
-    while (!orders.empty())
-    {
-        auto order = orders.front();
-        orders.pop();
-
-        if (order->id == order_id)
-        {
-            total_quantity -= order->quantity;
-            found = true;
-        }
-        else
-        {
-            temp_queue.push(order);
-        }
-    }
+    order->quantity -= quantity;
+    total_quantity -= quantity;
+    return true;
+}
+
+bool OrderQueue::remove_order(Order *order)
+{
+    if (!order)
+        return false;
 
-    orders = temp_queue;
-    return found;
-}
\ No newline at end of file
+    // Splice the neighbours together; time priority of the rest is unchanged
+    if (order->prev)
+        order->prev->next = order->next;
+    else
+        head = order->next;
+
+    if (order->next)
+        order->next->prev = order->prev;
+    else
+        tail = order->prev;
+
+    order->prev = nullptr;
+    order->next = nullptr;
+
+    total_quantity -= order->quantity;
+    order_count--;
+    return true;
+}
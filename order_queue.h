@@ -2,25 +2,30 @@
 #define ORDER_QUEUE_H
 
 #include "order.h"
-#include <queue>
-#include <memory>
+#include <cstddef>
 
 /**
  * @class OrderQueue
  * @brief Manages a queue of orders at a specific price level in a limit order book.
  *
- * This class maintains a queue of orders, tracks the total quantity of all orders,
+ * This class maintains an intrusive doubly-linked FIFO of orders, linked through
+ * Order::prev and Order::next, tracks the total quantity and count of all orders,
  * and provides methods for adding, removing, and querying orders in the queue.
+ * The queue does not own its orders; any order can be unlinked in constant time.
  */
 class OrderQueue
 {
 private:
-    // Queue of orders at this price level
-    std::queue<std::shared_ptr<Order>> orders;
+    // Oldest and newest orders at this price level
+    Order *head;
+    Order *tail;
 
     // Total quantity of all orders in the queue
     int total_quantity;
 
+    // Number of orders in the queue
+    size_t order_count;
+
 public:
     /**
      * @brief Constructs a new OrderQueue instance.
@@ -28,16 +33,16 @@ public:
     OrderQueue();
 
     /**
-     * @brief Adds an order to the queue.
-     * @param order The order to be added.
+     * @brief Adds an order to the back of the queue.
+     * @param order The order to be added. It must not be linked into any queue.
      */
-    void add_order(std::shared_ptr<Order> order);
+    void add_order(Order *order);
 
     /**
      * @brief Retrieves the order at the front of the queue.
-     * @return A shared pointer to the front order, or nullptr if the queue is empty.
+     * @return A pointer to the front order, or nullptr if the queue is empty.
      */
-    std::shared_ptr<Order> front();
+    Order *front() const;
 
     /**
      * @brief Removes the order at the front of the queue.
@@ -57,17 +62,31 @@ public:
     int get_total_quantity() const;
 
     /**
-     * @brief Updates the total quantity of the queue.
-     * @param new_quantity The new total quantity.
+     * @brief Gets the number of orders in the queue.
+     * @return The number of orders.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Updates the quantity of the order at the front of the queue.
+     * @param new_quantity The new quantity of the front order.
      */
     void update_quantity(int new_quantity);
 
     /**
-     * @brief Removes an order from the queue by its ID.
-     * @param order_id The unique ID of the order to remove.
-     * @return True if the order was successfully removed, false otherwise.
+     * @brief Reduces the quantity of any order in the queue without moving it.
+     * @param order The order to reduce. It must be linked into this queue.
+     * @param quantity Quantity to remove; must be positive and less than the order's quantity.
+     * @return False, leaving the order unchanged, if the quantity is out of that range.
+     */
+    bool reduce_order(Order *order, int quantity);
+
+    /**
+     * @brief Unlinks an order from the queue in constant time.
+     * @param order The order to remove. It must be linked into this queue.
+     * @return True if the order was removed, false if the pointer was null.
      */
-    bool remove_order(int order_id);
+    bool remove_order(Order *order);
 };
 
-#endif // ORDER_QUEUE_H
\ No newline at end of file
+#endif // ORDER_QUEUE_H
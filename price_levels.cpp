@@ -0,0 +1,263 @@
+#include "price_levels.h"
+
+namespace
+{
+    Price side_sign(OrderSide side)
+    {
+        return side == OrderSide::BUY ? -1 : 1;
+    }
+
+    // Rounds a key down onto the tick grid (floor semantics for negative bid keys)
+    Price align_to_grid(Price key, Price tick_size)
+    {
+        Price remainder = key % tick_size;
+        if (remainder < 0)
+            remainder += tick_size;
+        return key - remainder;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// MapPriceLevels
+// ---------------------------------------------------------------------------
+
+MapPriceLevels::MapPriceLevels(OrderSide side) : sign(side_sign(side)) {}
+
+bool MapPriceLevels::empty() const
+{
+    return levels.empty();
+}
+
+size_t MapPriceLevels::size() const
+{
+    return levels.size();
+}
+
+Price MapPriceLevels::best_price() const
+{
+    return sign * levels.begin()->first;
+}
+
+OrderQueue &MapPriceLevels::best_level()
+{
+    return levels.begin()->second;
+}
+
+const OrderQueue &MapPriceLevels::best_level() const
+{
+    return levels.begin()->second;
+}
+
+OrderQueue &MapPriceLevels::get_or_create(Price price)
+{
+    return levels[sign * price];
+}
+
+OrderQueue *MapPriceLevels::find(Price price)
+{
+    auto it = levels.find(sign * price);
+    if (it == levels.end())
+        return nullptr;
+    return &it->second;
+}
+
+void MapPriceLevels::erase(Price price)
+{
+    levels.erase(sign * price);
+}
+
+// ---------------------------------------------------------------------------
+// LadderPriceLevels
+// ---------------------------------------------------------------------------
+
+LadderPriceLevels::LadderPriceLevels(OrderSide side, Price tick_size)
+    : window(WINDOW_LEVELS), occupied{}, summary(0), sign(side_sign(side)),
+      tick_size(tick_size > 0 ? tick_size : 1), base_key(0), window_count(0) {}
+
+bool LadderPriceLevels::window_index(Price key, size_t &index) const
+{
+    Price offset = key - base_key;
+    if (offset < 0 || offset % tick_size != 0)
+        return false;
+
+    Price slot = offset / tick_size;
+    if (slot >= static_cast<Price>(WINDOW_LEVELS))
+        return false;
+
+    index = static_cast<size_t>(slot);
+    return true;
+}
+
+size_t LadderPriceLevels::first_occupied() const
+{
+    size_t word = static_cast<size_t>(__builtin_ctzll(summary));
+    return word * WORD_BITS + static_cast<size_t>(__builtin_ctzll(occupied[word]));
+}
+
+size_t LadderPriceLevels::next_occupied(size_t from) const
+{
+    if (from >= WINDOW_LEVELS)
+        return WINDOW_LEVELS;
+
+    // Rest of the current word first, then the summary for the next occupied word
+    size_t word = from / WORD_BITS;
+    uint64_t bits = occupied[word] & (~uint64_t(0) << (from % WORD_BITS));
+    if (bits)
+        return word * WORD_BITS + static_cast<size_t>(__builtin_ctzll(bits));
+
+    uint64_t words = word + 1 < SUMMARY_BITS ? summary & (~uint64_t(0) << (word + 1)) : 0;
+    if (!words)
+        return WINDOW_LEVELS;
+
+    word = static_cast<size_t>(__builtin_ctzll(words));
+    return word * WORD_BITS + static_cast<size_t>(__builtin_ctzll(occupied[word]));
+}
+
+bool LadderPriceLevels::is_occupied(size_t index) const
+{
+    return (occupied[index / WORD_BITS] >> (index % WORD_BITS)) & 1;
+}
+
+void LadderPriceLevels::mark_occupied(size_t index)
+{
+    size_t word = index / WORD_BITS;
+    occupied[word] |= uint64_t(1) << (index % WORD_BITS);
+    summary |= uint64_t(1) << word;
+    window_count++;
+}
+
+void LadderPriceLevels::mark_vacant(size_t index)
+{
+    size_t word = index / WORD_BITS;
+    occupied[word] &= ~(uint64_t(1) << (index % WORD_BITS));
+    if (occupied[word] == 0)
+        summary &= ~(uint64_t(1) << word);
+    window_count--;
+}
+
+void LadderPriceLevels::recenter(Price key)
+{
+    // Place the key mid-window so the book can drift either way before spilling
+    base_key = align_to_grid(key, tick_size) - static_cast<Price>(WINDOW_LEVELS / 2) * tick_size;
+
+    // Pull any overflow levels that now fit into the array
+    Price window_end = base_key + static_cast<Price>(WINDOW_LEVELS) * tick_size;
+    auto it = overflow.lower_bound(base_key);
+    while (it != overflow.end() && it->first < window_end)
+    {
+        size_t index;
+        if (window_index(it->first, index))
+        {
+            window[index] = std::move(it->second);
+            mark_occupied(index);
+            it = overflow.erase(it);
+        }
+        else
+            ++it;
+    }
+}
+
+bool LadderPriceLevels::best_in_overflow() const
+{
+    if (overflow.empty())
+        return false;
+    if (window_count == 0)
+        return true;
+
+    Price window_best = base_key + static_cast<Price>(first_occupied()) * tick_size;
+    return overflow.begin()->first < window_best;
+}
+
+bool LadderPriceLevels::empty() const
+{
+    return window_count == 0 && overflow.empty();
+}
+
+size_t LadderPriceLevels::size() const
+{
+    return window_count + overflow.size();
+}
+
+Price LadderPriceLevels::best_price() const
+{
+    if (best_in_overflow())
+        return sign * overflow.begin()->first;
+    return sign * (base_key + static_cast<Price>(first_occupied()) * tick_size);
+}
+
+OrderQueue &LadderPriceLevels::best_level()
+{
+    if (best_in_overflow())
+        return overflow.begin()->second;
+    return window[first_occupied()];
+}
+
+const OrderQueue &LadderPriceLevels::best_level() const
+{
+    if (best_in_overflow())
+        return overflow.begin()->second;
+    return window[first_occupied()];
+}
+
+OrderQueue &LadderPriceLevels::get_or_create(Price price)
+{
+    Price key = sign * price;
+    size_t index;
+
+    if (!window_index(key, index) && window_count == 0 && key % tick_size == 0)
+        recenter(key);
+
+    if (window_index(key, index))
+    {
+        if (!is_occupied(index))
+            mark_occupied(index);
+        return window[index];
+    }
+
+    return overflow[key];
+}
+
+OrderQueue *LadderPriceLevels::find(Price price)
+{
+    Price key = sign * price;
+    size_t index;
+
+    if (window_index(key, index))
+    {
+        if (is_occupied(index))
+            return &window[index];
+        return nullptr;
+    }
+
+    auto it = overflow.find(key);
+    if (it == overflow.end())
+        return nullptr;
+    return &it->second;
+}
+
+void LadderPriceLevels::erase(Price price)
+{
+    Price key = sign * price;
+    size_t index;
+
+    if (window_index(key, index))
+    {
+        if (!is_occupied(index))
+            return;
+
+        mark_vacant(index);
+
+        // Keep the array hot: move the window to wherever the overflow levels live
+        if (window_count == 0 && !overflow.empty())
+            recenter(overflow.begin()->first);
+    }
+    else
+        overflow.erase(key);
+}
+
+void LadderPriceLevels::prefetch(Price price) const
+{
+    size_t index;
+    if (window_index(sign * price, index))
+        prefetch_memory(&window[index]);
+}
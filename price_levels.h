@@ -0,0 +1,289 @@
+#ifndef PRICE_LEVELS_H
+#define PRICE_LEVELS_H
+
+#include "order.h"
+#include "order_queue.h"
+#include <array>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+/**
+ * @class MapPriceLevels
+ * @brief Price level store for one side of the book backed by a std::map.
+ *
+ * Levels are keyed by a priority key (the price for asks, the negated price for
+ * bids) so that the first map entry is always the best level on either side.
+ */
+class MapPriceLevels
+{
+private:
+    // Priority key -> OrderQueue (best level first)
+    std::map<Price, OrderQueue> levels;
+
+    // +1 for asks, -1 for bids; maps prices to priority keys and back
+    Price sign;
+
+public:
+    /**
+     * @brief Constructs an empty level store for one side of the book.
+     * @param side The side of the book this store holds.
+     */
+    explicit MapPriceLevels(OrderSide side);
+
+    /**
+     * @brief Checks if there are no price levels.
+     * @return True if the store holds no levels, false otherwise.
+     */
+    bool empty() const;
+
+    /**
+     * @brief Gets the number of non-empty price levels.
+     * @return The number of levels.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Gets the best price on this side (highest bid or lowest ask).
+     * @return The best price in ticks. The store must not be empty.
+     */
+    Price best_price() const;
+
+    /**
+     * @brief Gets the order queue at the best price.
+     * @return The best level. The store must not be empty.
+     */
+    OrderQueue &best_level();
+
+    /**
+     * @brief Gets the order queue at the best price.
+     * @return The best level. The store must not be empty.
+     */
+    const OrderQueue &best_level() const;
+
+    /**
+     * @brief Gets the level at a price, creating an empty one if needed.
+     * @param price The price in ticks.
+     * @return The order queue at that price.
+     */
+    OrderQueue &get_or_create(Price price);
+
+    /**
+     * @brief Finds the level at a price.
+     * @param price The price in ticks.
+     * @return The order queue at that price, or nullptr if there is none.
+     */
+    OrderQueue *find(Price price);
+
+    /**
+     * @brief Removes the level at a price.
+     * @param price The price in ticks.
+     */
+    void erase(Price price);
+
+    /**
+     * @brief Does nothing: a tree level cannot be located without walking the tree.
+     * @param price The price in ticks.
+     */
+    void prefetch(Price price) const { (void)price; }
+
+    /**
+     * @brief Visits the best levels in priority order, without allocating.
+     * @param max_levels Maximum number of levels to visit.
+     * @param visit Called as visit(price, queue) for each level.
+     * @return The number of levels visited.
+     */
+    template <typename Visitor>
+    size_t visit_levels(size_t max_levels, Visitor &&visit) const;
+};
+
+/**
+ * @class LadderPriceLevels
+ * @brief Price level store for one side of the book backed by a tick-indexed array.
+ *
+ * Levels inside a window of WINDOW_LEVELS ticks are stored in a contiguous array and
+ * tracked by a two-level occupancy bitmap, so the best level and the next non-empty
+ * level are found with count-trailing-zeros instead of a tree walk. Like the map store
+ * the array is indexed by priority key, so index 0 is the most aggressive price.
+ *
+ * Prices outside the window, or not on the tick grid, spill into an overflow map.
+ * When the window runs empty it is recentred on the best overflow price.
+ */
+class LadderPriceLevels
+{
+public:
+    /** Number of price levels held in the array window (64 x 64 bitmap). */
+    static constexpr size_t WINDOW_LEVELS = 4096;
+
+    /** Default tick grid spacing: one cent, the NASDAQ tick for stocks above $1. */
+    static constexpr Price DEFAULT_TICK_SIZE = PRICE_SCALE / 100;
+
+private:
+    static constexpr size_t WORD_BITS = 64;
+    static constexpr size_t SUMMARY_BITS = WINDOW_LEVELS / WORD_BITS;
+    static_assert(SUMMARY_BITS <= WORD_BITS, "summary bitmap must fit in a single word");
+
+    // Array window of levels, indexed by (key - base_key) / tick_size
+    std::vector<OrderQueue> window;
+
+    // Occupancy bitmaps: one bit per window level, one summary bit per word
+    std::array<uint64_t, SUMMARY_BITS> occupied;
+    uint64_t summary;
+
+    // Levels that fall outside the window or off the tick grid, keyed by priority key
+    std::map<Price, OrderQueue> overflow;
+
+    Price sign;           // +1 for asks, -1 for bids
+    Price tick_size;      // Grid spacing of the window in ticks
+    Price base_key;       // Priority key of window index 0
+    size_t window_count;  // Number of occupied window levels
+
+    /**
+     * @brief Maps a priority key to a window index.
+     * @param key The priority key.
+     * @param index Receives the window index when the key is inside the window.
+     * @return True if the key is on the grid and inside the window, false otherwise.
+     */
+    bool window_index(Price key, size_t &index) const;
+
+    /**
+     * @brief Gets the lowest occupied window index.
+     * @return The index of the best window level. The window must not be empty.
+     */
+    size_t first_occupied() const;
+
+    /**
+     * @brief Gets the lowest occupied window index at or after a position.
+     * @param from The first index to consider.
+     * @return The index of the next occupied level, or WINDOW_LEVELS if there is none.
+     */
+    size_t next_occupied(size_t from) const;
+
+    bool is_occupied(size_t index) const;
+    void mark_occupied(size_t index);
+    void mark_vacant(size_t index);
+
+    /**
+     * @brief Re-anchors an empty window around a key and pulls in overflow levels.
+     * @param key The priority key to place in the window.
+     */
+    void recenter(Price key);
+
+    /**
+     * @brief Checks whether the best level is in the overflow map.
+     * @return True if the overflow map holds a better level than the window.
+     */
+    bool best_in_overflow() const;
+
+public:
+    /**
+     * @brief Constructs an empty level store for one side of the book.
+     * @param side The side of the book this store holds.
+     * @param tick_size The price grid spacing of the array window in ticks.
+     */
+    explicit LadderPriceLevels(OrderSide side, Price tick_size = DEFAULT_TICK_SIZE);
+
+    /**
+     * @brief Checks if there are no price levels.
+     * @return True if the store holds no levels, false otherwise.
+     */
+    bool empty() const;
+
+    /**
+     * @brief Gets the number of non-empty price levels.
+     * @return The number of levels.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Gets the best price on this side (highest bid or lowest ask).
+     * @return The best price in ticks. The store must not be empty.
+     */
+    Price best_price() const;
+
+    /**
+     * @brief Gets the order queue at the best price.
+     * @return The best level. The store must not be empty.
+     */
+    OrderQueue &best_level();
+
+    /**
+     * @brief Gets the order queue at the best price.
+     * @return The best level. The store must not be empty.
+     */
+    const OrderQueue &best_level() const;
+
+    /**
+     * @brief Gets the level at a price, creating an empty one if needed.
+     * @param price The price in ticks.
+     * @return The order queue at that price.
+     */
+    OrderQueue &get_or_create(Price price);
+
+    /**
+     * @brief Finds the level at a price.
+     * @param price The price in ticks.
+     * @return The order queue at that price, or nullptr if there is none.
+     */
+    OrderQueue *find(Price price);
+
+    /**
+     * @brief Removes the level at a price.
+     * @param price The price in ticks.
+     */
+    void erase(Price price);
+
+    /**
+     * @brief Starts loading the window slot of a price, if it has one.
+     * @param price The price in ticks.
+     */
+    void prefetch(Price price) const;
+
+    /**
+     * @brief Visits the best levels in priority order, without allocating.
+     *
+     * Window levels are found through the occupancy bitmap and merged with the overflow map.
+     * @param max_levels Maximum number of levels to visit.
+     * @param visit Called as visit(price, queue) for each level.
+     * @return The number of levels visited.
+     */
+    template <typename Visitor>
+    size_t visit_levels(size_t max_levels, Visitor &&visit) const;
+};
+
+template <typename Visitor>
+size_t MapPriceLevels::visit_levels(size_t max_levels, Visitor &&visit) const
+{
+    size_t count = 0;
+    for (auto it = levels.begin(); it != levels.end() && count < max_levels; ++it, ++count)
+        visit(sign * it->first, it->second);
+    return count;
+}
+
+template <typename Visitor>
+size_t LadderPriceLevels::visit_levels(size_t max_levels, Visitor &&visit) const
+{
+    size_t count = 0;
+    size_t index = window_count > 0 ? first_occupied() : WINDOW_LEVELS;
+    auto it = overflow.begin();
+
+    // Both sources are in priority key order; take whichever level comes first
+    while (count < max_levels && (index < WINDOW_LEVELS || it != overflow.end()))
+    {
+        Price window_key = base_key + static_cast<Price>(index) * tick_size;
+        if (it != overflow.end() && (index >= WINDOW_LEVELS || it->first < window_key))
+        {
+            visit(sign * it->first, it->second);
+            ++it;
+        }
+        else
+        {
+            visit(sign * window_key, window[index]);
+            index = next_occupied(index + 1);
+        }
+        count++;
+    }
+    return count;
+}
+
+#endif // PRICE_LEVELS_H
@@ -0,0 +1,130 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @class SpscRing
+ * @brief Bounded lock-free ring buffer for exactly one producer and one consumer thread.
+ *
+ * The read and write positions live on separate cache lines, each next to a cached
+ * copy of the other side's position, so a push or pop only touches the shared line
+ * when its cached view says the ring is full or empty. A full ring pushes back on the
+ * producer (try_push fails); close() marks the end of the stream for the consumer.
+ *
+ * @tparam T The element type. Must be default constructible and copy assignable.
+ */
+template <typename T>
+class SpscRing
+{
+public:
+    /** Assumed cache line size, used to keep the two sides from false sharing. */
+    static constexpr size_t CACHE_LINE = 64;
+
+private:
+    std::vector<T> slots; // Ring storage, a power of two in size
+    size_t mask;          // slots.size() - 1
+
+    // Consumer side
+    alignas(CACHE_LINE) std::atomic<size_t> head; // Next position to read
+    size_t cached_tail;                           // Consumer's last view of tail
+
+    // Producer side
+    alignas(CACHE_LINE) std::atomic<size_t> tail; // Next position to write
+    size_t cached_head;                           // Producer's last view of head
+
+    alignas(CACHE_LINE) std::atomic<bool> closed; // Set once the producer is done
+
+    static size_t round_up(size_t n)
+    {
+        size_t capacity = 2;
+        while (capacity < n)
+            capacity <<= 1;
+        return capacity;
+    }
+
+public:
+    /**
+     * @brief Constructs an empty ring.
+     * @param capacity Minimum number of elements the ring holds (rounded up to a power of two).
+     */
+    explicit SpscRing(size_t capacity)
+        : slots(round_up(capacity)), mask(slots.size() - 1), head(0), cached_tail(0),
+          tail(0), cached_head(0), closed(false) {}
+
+    SpscRing(const SpscRing &) = delete;
+    SpscRing &operator=(const SpscRing &) = delete;
+
+    /**
+     * @brief Appends an element. Producer thread only.
+     * @param value The element to append.
+     * @return True if it was appended, false if the ring is full.
+     */
+    bool try_push(const T &value)
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - cached_head > mask)
+        {
+            cached_head = head.load(std::memory_order_acquire);
+            if (t - cached_head > mask)
+                return false;
+        }
+
+        slots[t & mask] = value;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Removes the oldest element. Consumer thread only.
+     * @param value Receives the element.
+     * @return True if an element was removed, false if the ring is empty.
+     */
+    bool try_pop(T &value)
+    {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == cached_tail)
+        {
+            cached_tail = tail.load(std::memory_order_acquire);
+            if (h == cached_tail)
+                return false;
+        }
+
+        value = slots[h & mask];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Marks the end of the stream. Producer thread only, after its last push.
+     */
+    void close()
+    {
+        closed.store(true, std::memory_order_release);
+    }
+
+    /**
+     * @brief Checks whether the producer has finished.
+     *
+     * Once this returns true every element has been pushed, so a following failed
+     * try_pop means the stream is drained.
+     * @return True after close() was called.
+     */
+    bool is_closed() const
+    {
+        return closed.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Gets the number of elements the ring can hold.
+     * @return The capacity.
+     */
+    size_t capacity() const
+    {
+        return slots.size();
+    }
+};
+
+#endif // SPSC_RING_H